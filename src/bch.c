@@ -0,0 +1,134 @@
+/******************************************************************************
+ * @file bch.c
+ * @brief BCH(31,21) + parita pro POCSAG - tabulkovy vypocet syndromu
+ *
+ * Syndrom je linearni funkce slova (GF(2)), takze syndrom celeho slova
+ * je XOR syndromu jeho jednotlivych bajtu. Pro kazdou ze 4 pozic bajtu
+ * je tabulka 256 predpocitanych syndromu -> 4 cteni z tabulky a 3 XOR
+ * misto 21 kroku polynomialniho deleni.
+ *
+ * Oprava chyb: syndrom indexuje tabulku chybovych vzoru pro vsechny 1 a 2
+ * bitove chyby, paritni bit rozlisi 2 chyby od 3 (ty se neopravuji).
+ *
+ * Kodovani: kontrolni bity jsou zbytek deleni dat (bity 31..11, ostatni 0),
+ * tedy primo syndrom takoveho slova - stejna tabulka slouzi i pro vysilani.
+ *
+ * Tabulky se generuji z generatoru 0x769 v BCH_Init() (jednou pri startu),
+ * protoze managed build Simplicity Studia nema krok pro generovani zdroju.
+ *****************************************************************************/
+#include "bch.h"
+
+static uint16_t syndrom_tab[4][256];  // [pozice bajtu][hodnota bajtu]
+
+//-- Tabulka syndrom -> chybovy vzor pro 1 a 2 chyby v bitech 31..1
+//   bity 4..0 = pozice 1. chyby, bity 9..5 = pozice 2. chyby, bity 11..10 = pocet chyb
+//   0 = syndrom neodpovida zadne 1 ani 2 bitove chybe
+static uint16_t error_tab[1024];       // index = syndrom >> 1
+
+//------------------------------------------------------------------------------
+// Puvodni bitove deleni - pouziva se jen pro generovani tabulek
+//------------------------------------------------------------------------------
+static uint32_t syndrom_serial(uint32_t word) {
+    // Bit 31 je x^30, bit 0 je parita a do syndromu nevstupuje
+    uint32_t reg  = word & 0xFFFFFFFE;
+    uint32_t poly = (uint32_t)BCH_GENERATOR << 21;  // x^10 zarovnany na bit 31
+
+    for (int i = 0; i < 21; i++) {
+        if (reg & (1UL << (31 - i))) {
+            reg ^= (poly >> i);
+        }
+    }
+    return (reg & 0x000007FE);
+}
+
+//------------------------------------------------------------------------------
+// Vygeneruje tabulky syndromu
+//------------------------------------------------------------------------------
+void BCH_Init(void) {
+    for (int pos = 0; pos < 4; pos++) {
+        for (uint32_t v = 0; v < 256; v++) {
+            syndrom_tab[pos][v] = (uint16_t)syndrom_serial(v << (8 * pos));
+        }
+    }
+
+    //-- Chybove vzory, parita (bit 0) do syndromu nevstupuje
+    for (int i = 0; i < 1024; i++) error_tab[i] = 0;
+    for (int a = 1; a < 32; a++) {
+        error_tab[BCH_Syndrome(1UL << a) >> 1] = (uint16_t)((1 << 10) | a);
+        for (int b = a + 1; b < 32; b++) {
+            error_tab[BCH_Syndrome((1UL << a) | (1UL << b)) >> 1] = (uint16_t)((2 << 10) | (b << 5) | a);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Syndrom slova - stejny vysledek jako bitove deleni, syndrom je v bitech 10..1
+//------------------------------------------------------------------------------
+uint32_t BCH_Syndrome(uint32_t word) {
+    return syndrom_tab[3][(word >> 24)       ]
+         ^ syndrom_tab[2][(word >> 16) & 0xFF]
+         ^ syndrom_tab[1][(word >>  8) & 0xFF]
+         ^ syndrom_tab[0][(word      ) & 0xFF];
+}
+
+//------------------------------------------------------------------------------
+// Suda parita pres vsech 32 bitu (skladani XOR misto smycky pres bity)
+//------------------------------------------------------------------------------
+bool BCH_Parity(uint32_t word) {
+    word ^= word >> 16;
+    word ^= word >> 8;
+    word ^= word >> 4;
+    return ((0x6996 >> (word & 0x0F)) & 1) == 0;
+}
+
+//------------------------------------------------------------------------------
+// Oprava slova podle syndromu a parity - konstantni cas
+// Vraci pocet opravenych bitu (0, 1, 2), nebo -1 pokud je slovo neopravitelne.
+// Slovo se prepise jen pri uspesne oprave.
+//
+//   syndrom  parita   vysledek
+//   0        suda     bez chyby
+//   0        licha    chyba v paritnim bitu -> 1 bit
+//   1 chyba  licha    1 bit
+//   1 chyba  suda     chyba v datech + v paritnim bitu -> 2 bity
+//   2 chyby  suda     2 bity
+//   2 chyby  licha    3 chyby -> neopravitelne
+//------------------------------------------------------------------------------
+int8_t BCH_Correct(uint32_t *word) {
+    uint32_t w    = *word;
+    uint32_t s    = BCH_Syndrome(w) >> 1;
+    bool     odd  = !BCH_Parity(w);
+
+    if (s == 0) {
+        if (!odd) return 0;
+        *word = w ^ 1UL;
+        return 1;
+    }
+
+    uint16_t e = error_tab[s];
+    uint8_t  n = (uint8_t)(e >> 10);
+    if (n == 0) return -1;                  // 3 a vice chyb
+
+    w ^= 1UL << (e & 0x1F);
+    if (n == 2) {
+        if (odd) return -1;                 // 2 chyby v datech + licha parita = 3 chyby
+        w ^= 1UL << ((e >> 5) & 0x1F);
+    }
+    else if (!odd) {
+        w ^= 1UL;                           // druha chyba je v paritnim bitu
+        n = 2;
+    }
+
+    *word = w;
+    return (int8_t)n;
+}
+
+//------------------------------------------------------------------------------
+// Zakodovani slova - data v bitech 31..11, bity 10..0 se dopocitaji
+//------------------------------------------------------------------------------
+uint32_t BCH_Encode(uint32_t word) {
+    word &= 0xFFFFF800;
+    word |= BCH_Syndrome(word);             // kontrolni bity 10..1
+    if (!BCH_Parity(word)) word |= 1UL;     // suda parita
+    return word;
+}
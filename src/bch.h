@@ -0,0 +1,19 @@
+/******************************************************************************
+ * @file bch.h
+ * @brief BCH(31,21) + parita pro POCSAG - tabulkovy vypocet syndromu
+ *****************************************************************************/
+#ifndef BCH_H
+#define BCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BCH_GENERATOR  0x769  // g(x) = x^10 + x^9 + x^8 + x^6 + x^5 + x^3 + 1
+
+void     BCH_Init(void);               // vygeneruje tabulky, volat jednou pri startu
+uint32_t BCH_Syndrome(uint32_t word);  // syndrom v bitech 10..1, 0 = slovo bez chyby
+bool     BCH_Parity(uint32_t word);    // true = suda parita celeho slova
+int8_t   BCH_Correct(uint32_t *word);  // pocet opravenych bitu 0..2, -1 = neopravitelne
+uint32_t BCH_Encode(uint32_t word);    // z dat v bitech 31..11 slozi slovo s BCH a paritou
+
+#endif /* BCH_H */
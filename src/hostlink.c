@@ -0,0 +1,306 @@
+/******************************************************************************
+ * @file hostlink.c
+ * @brief Binarni protokol pro nadrazeny system - COBS ramce s CRC-16
+ *
+ * Textovy vypis tokenu stoji cca 30 bajtu na slovo a host ho musi parsovat.
+ * Tady jde token binarne (5 bajtu na slovo) po portu param.host_port
+ * (1 = COM-A, 3 = COM-C, 0 = vypnuto). Port je pak jen pro protokol.
+ *
+ * Ramec na lince:  COBS(payload) 0x00
+ * payload:         typ(1) seq(1) data(n) crc(2)
+ *   crc = CRC-16/CCITT-FALSE (0x1021, init 0xFFFF) pres typ..data
+ *   vsechna vicebajtova cisla jsou little-endian
+ *
+ * HOST_MSG_TOKEN (zarizeni -> host), seq = poradi tokenu mod 256
+ *   uptime_s(4) fs_ticks(4) flags(1) net(1) token_id(1) adr(1) dau(1)
+ *   path(1) master(1) batch(1) bps(2) rate_mHz(4) drift_ppm(4)
+ *   period_start(4) period_end(4) sync_dist(1) fixed_words(2)
+ *   error_words(2) total_words(2) { data(4) status(1) } x total_words
+ *     flags: bit0 rx_ok, bit1 hlavicka ok, bit2 obracena polarita,
+ *            bit3 systemovy token
+ *     fs_ticks: WTIMER0 (72MHz, volne bezici, nenuluje se) pri prvnim FS,
+ *               pretece po 59,65 s - poradi a rozestup tokenu = rozdil
+ *               modulo 2^32, hrube poradi podle uptime_s (vteriny od startu)
+ *     status: WORD_xxx z pocsag.h
+ *
+ * HOST_MSG_TX (host -> zarizeni)
+ *   prio(1) flags(1) net(1) token_id(1) adr(1) dau(1) path(1) master(1)
+ *   batch(1) total_words(2) { data(4) } x total_words
+ *     slova 0..2 se prepisi hlavickou z poli, BCH a parita se dopocitaji,
+ *     neuplna posledni batch se doplni IDLE slovy
+ *
+ * HOST_MSG_ACK (zarizeni -> host), seq = seq prikazu
+ *   vysledek(1) = HOST_ACK_xxx
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "hostlink.h"
+#include "serial.h"
+#include "parameters.h"
+#include "timer0.h"
+
+#define HOST_TOKEN_HDR   41     // pevna cast HOST_MSG_TOKEN
+#define HOST_TX_HDR      11     // pevna cast HOST_MSG_TX
+#define HOST_PAYLOAD_MAX (2 + HOST_TOKEN_HDR + 5 * MAX_BATCHES * WORDS_PER_BATCH + 2)
+#define HOST_FRAME_MAX   (HOST_PAYLOAD_MAX + HOST_PAYLOAD_MAX / 254 + 2)
+
+static int8_t   host_com = -1;                 // SERIAL_COM_x, -1 = vypnuto
+static uint8_t  host_payload[HOST_PAYLOAD_MAX];
+static uint8_t  host_frame[HOST_FRAME_MAX];    // vysilany ramec (COBS + 0x00)
+static uint8_t  host_rx[HOST_FRAME_MAX];       // prijimany ramec (COBS, bez 0x00)
+static uint16_t host_rx_len = 0;
+static bool     host_rx_skip = false;          // preteceni, ceka na dalsi 0x00
+static uint8_t  host_seq = 0;
+
+//--- Pocitadla (prikaz 'u')
+static uint32_t host_tx_frames = 0;
+static uint32_t host_tx_drops = 0;             // nevesel se do bufferu portu
+static uint32_t host_rx_frames = 0;
+static uint32_t host_rx_errors = 0;            // CRC, COBS nebo preteceni
+
+//------------------------------------------------------------------------------
+// CRC-16/CCITT-FALSE
+//------------------------------------------------------------------------------
+static uint16_t crc16(const uint8_t *p, uint16_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+//------------------------------------------------------------------------------
+// COBS - vraci delku vystupu (bez ukoncovaci 0x00)
+//------------------------------------------------------------------------------
+static uint16_t cobs_encode(const uint8_t *in, uint16_t len, uint8_t *out) {
+    uint16_t code_pos = 0;
+    uint16_t o = 1;
+    uint8_t  code = 1;
+
+    for (uint16_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        } else {
+            out[o++] = in[i];
+            if (++code == 0xFF) {
+                out[code_pos] = code;
+                code_pos = o++;
+                code = 1;
+            }
+        }
+    }
+    out[code_pos] = code;
+    return o;
+}
+
+// Dekoduje na miste, vraci delku nebo -1 pri chybe
+static int16_t cobs_decode(uint8_t *buf, uint16_t len) {
+    uint16_t i = 0;
+    uint16_t o = 0;
+
+    while (i < len) {
+        uint8_t code = buf[i++];
+        if (code == 0 || i + code - 1 > len) return -1;
+        for (uint8_t k = 1; k < code; k++) buf[o++] = buf[i++];
+        if (code != 0xFF && i < len) buf[o++] = 0;
+    }
+    return (int16_t)o;
+}
+
+//------------------------------------------------------------------------------
+// Zapis little-endian do payloadu
+//------------------------------------------------------------------------------
+static uint16_t put8(uint16_t n, uint8_t v)   { host_payload[n] = v; return n + 1; }
+static uint16_t put16(uint16_t n, uint16_t v) { n = put8(n, (uint8_t)v); return put8(n, (uint8_t)(v >> 8)); }
+static uint16_t put32(uint16_t n, uint32_t v) { n = put16(n, (uint16_t)v); return put16(n, (uint16_t)(v >> 16)); }
+
+static uint16_t get16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get32(const uint8_t *p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+
+//------------------------------------------------------------------------------
+// Doplni CRC, zakoduje a posle cely ramec - nebo nic, kdyz se nevejde
+//------------------------------------------------------------------------------
+static void host_send(uint16_t n) {
+    n = put16(n, crc16(host_payload, n));
+    uint16_t len = cobs_encode(host_payload, n, host_frame);
+    host_frame[len++] = 0;
+
+    if (Serial_TxFree((uint8_t)host_com) < len) {
+        host_tx_drops++;
+        return;
+    }
+    Serial_Write((uint8_t)host_com, (const char *)host_frame, len);
+    host_tx_frames++;
+}
+
+static void host_ack(uint8_t seq, uint8_t result) {
+    uint16_t n = 0;
+    n = put8(n, HOST_MSG_ACK);
+    n = put8(n, seq);
+    n = put8(n, result);
+    host_send(n);
+}
+
+//------------------------------------------------------------------------------
+// Prijaty token -> HOST_MSG_TOKEN
+//------------------------------------------------------------------------------
+void HOST_SendToken(const POCSAG_token *t, bool hdr_ok) {
+    if (host_com < 0) return;
+
+    uint16_t words = t->total_words;
+    if (words > MAX_BATCHES * WORDS_PER_BATCH) words = MAX_BATCHES * WORDS_PER_BATCH;
+
+    uint16_t n = 0;
+    n = put8(n, HOST_MSG_TOKEN);
+    n = put8(n, host_seq++);
+    n = put32(n, t->uptime_s);
+    n = put32(n, t->fs_ticks);
+    n = put8(n, (uint8_t)((t->rx_ok ? 0x01 : 0) | (hdr_ok ? 0x02 : 0)
+                        | (t->inverted ? 0x04 : 0) | (t->system_token ? 0x08 : 0)));
+    n = put8(n, t->net);
+    n = put8(n, t->token_id);
+    n = put8(n, t->adr);
+    n = put8(n, t->dau);
+    n = put8(n, t->path);
+    n = put8(n, t->master);
+    n = put8(n, t->batch);
+    n = put16(n, t->bps);
+    n = put32(n, t->rate_mHz);
+    n = put32(n, (uint32_t)t->drift_ppm);
+    n = put32(n, t->period_start);
+    n = put32(n, t->period_end);
+    n = put8(n, t->sync_dist);
+    n = put16(n, t->fixed_words);
+    n = put16(n, t->error_words);
+    n = put16(n, words);
+    for (uint16_t i = 0; i < words; i++) {
+        n = put32(n, t->data[i]);
+        n = put8(n, t->status[i]);
+    }
+    host_send(n);
+}
+
+//------------------------------------------------------------------------------
+// HOST_MSG_TX -> fronta vysilani
+//------------------------------------------------------------------------------
+static uint8_t host_rx_tx(const uint8_t *d, uint16_t len) {
+    static POCSAG_token t;   // velka struktura, ne na zasobnik
+
+    if (len < HOST_TX_HDR) return HOST_ACK_BAD;
+    uint16_t words = get16(&d[9]);
+    if (words < 3 || words > MAX_BATCHES * WORDS_PER_BATCH) return HOST_ACK_BAD;
+    if (len != HOST_TX_HDR + 4 * words) return HOST_ACK_BAD;
+    if (d[0] >= POCSAG_TXQ_PRIOS) return HOST_ACK_BAD;
+
+    memset(&t, 0, sizeof(t));
+    t.system_token = (d[1] & 0x08) ? 1 : 0;
+    t.net      = d[2];
+    t.token_id = d[3];
+    t.adr      = d[4];
+    t.dau      = d[5];
+    t.path     = d[6];
+    t.master   = d[7];
+    t.batch    = d[8];
+    t.total_words = words;
+    for (uint16_t i = 0; i < words; i++) {
+        t.data[i] = get32(&d[HOST_TX_HDR + 4 * i]);
+    }
+    return POCSAG_tx_inject(&t, d[0]) ? HOST_ACK_OK : HOST_ACK_FULL;
+}
+
+//------------------------------------------------------------------------------
+// Jeden prijaty ramec (uz bez 0x00)
+//------------------------------------------------------------------------------
+static void host_frame_rx(void) {
+    int16_t len = cobs_decode(host_rx, host_rx_len);
+    if (len < 4 || crc16(host_rx, (uint16_t)(len - 2)) != get16(&host_rx[len - 2])) {
+        host_rx_errors++;
+        return;
+    }
+    host_rx_frames++;
+
+    uint8_t  type = host_rx[0];
+    uint8_t  seq  = host_rx[1];
+    uint16_t dlen = (uint16_t)(len - 4);
+
+    switch (type) {
+        case HOST_MSG_TX:
+            host_ack(seq, host_rx_tx(&host_rx[2], dlen));
+            break;
+
+        case HOST_MSG_PING:
+            host_ack(seq, HOST_ACK_OK);
+            break;
+
+        default:
+            host_ack(seq, HOST_ACK_UNKNOWN);
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Prijem - bajty do 0x00 tvori ramec
+//------------------------------------------------------------------------------
+void HOST_Poll(void) {
+    uint8_t  chunk[64];
+    uint16_t n;
+
+    if (host_com < 0) return;
+
+    while ((n = Serial_Read((uint8_t)host_com, (char *)chunk, sizeof(chunk))) != 0) {
+        for (uint16_t i = 0; i < n; i++) {
+            if (chunk[i] == 0) {
+                if (!host_rx_skip && host_rx_len != 0) host_frame_rx();
+                host_rx_len = 0;
+                host_rx_skip = false;
+            }
+            else if (host_rx_len < sizeof(host_rx)) {
+                host_rx[host_rx_len++] = chunk[i];
+            }
+            else if (!host_rx_skip) {
+                host_rx_skip = true;
+                host_rx_errors++;
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Port podle parametru - prevezme ho protokol (bez skladani radku).
+// Vola se i pri zmene param.host_port za behu (set host_port), drivejsi port
+// pak dostane zpet vychozi obsluhu radku.
+//------------------------------------------------------------------------------
+void HOST_Init(void) {
+    if (host_com >= 0) {
+        Serial_DefaultHandlers((uint8_t)host_com);
+    }
+    host_rx_len = 0;
+    host_rx_skip = false;
+
+    switch (param.host_port) {
+        case 1:  host_com = SERIAL_COM_A; break;
+        case 3:  host_com = SERIAL_COM_C; break;
+        default: host_com = -1;           break;
+    }
+    if (host_com >= 0) {
+        Serial_SetHandlers((uint8_t)host_com, NULL, NULL);
+    }
+}
+
+void HOST_ShowStats(void) {
+    char txt[100];
+
+    if (host_com < 0) {
+        sendStringUART1(" HOST: vypnuto\r\n");
+        return;
+    }
+    sprintf(txt, " HOST %s: tx=%lu drop=%lu rx=%lu err=%lu\r\n", serial_ports[host_com].name,
+            (unsigned long)host_tx_frames, (unsigned long)host_tx_drops,
+            (unsigned long)host_rx_frames, (unsigned long)host_rx_errors);
+    sendStringUART1(txt);
+}
@@ -0,0 +1,29 @@
+/******************************************************************************
+ * @file hostlink.h
+ * @brief Binarni protokol pro nadrazeny system - COBS ramce s CRC-16
+ *****************************************************************************/
+#ifndef HOSTLINK_H
+#define HOSTLINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pocsag.h"
+
+//--- Typy zprav (prvni bajt payloadu)
+#define HOST_MSG_TOKEN   0x01   // zarizeni -> host: prijaty token
+#define HOST_MSG_ACK     0x02   // zarizeni -> host: vysledek prikazu
+#define HOST_MSG_TX      0x81   // host -> zarizeni: token k vysilani
+#define HOST_MSG_PING    0x82   // host -> zarizeni: odpovi ACK
+
+//--- Vysledek v HOST_MSG_ACK
+#define HOST_ACK_OK      0      // provedeno / zarazeno do fronty
+#define HOST_ACK_FULL    1      // fronta vysilani plna
+#define HOST_ACK_BAD     2      // chybna delka nebo hodnoty
+#define HOST_ACK_UNKNOWN 3      // neznamy typ zpravy
+
+void HOST_Init(void);           // podle param.host_port, po initSerial a Parameters_Init
+void HOST_Poll(void);           // prijate ramce, z hlavni smycky
+void HOST_SendToken(const POCSAG_token *token, bool hdr_ok);
+void HOST_ShowStats(void);
+
+#endif /* HOSTLINK_H */
@@ -6,12 +6,16 @@
 #include "em_gpio.h"
 #include "em_cmu.h"
 #include "em_timer.h"
+#include "em_prs.h"
+#include "em_ldma.h"
 
 #include "inputs.h"
 #include "ports.h"
 #include "pocsag.h"
 #include "timer1.h"
 
+static void initRXCapture(void);
+
 //--- Kalibrace rychlosti prijmu
 bool calib_start = false;
 bool calib_stop = false;
@@ -19,6 +23,22 @@ uint32_t calib_start_counter = 0;
 uint32_t calib_stop_counter = 0;
 uint16_t calib_bits = 0;
 uint32_t calib_count_per_bit = 0; //-- Pocet tiku na bit (aby to nemusel porad pocitat)
+static uint32_t calib_start_snap = 0;   // WTIMER0 pri detekci preamble
+static uint32_t calib_stop_snap = 0;    // WTIMER0 na konci preamble
+static bool calib_started = false;      // calib_start_counter je platny
+
+//--- Casove znacky hran RX: PA0 -> PRS -> WTIMER0 CC0 (capture) -> LDMA -> edge_ring[]
+//    LDMA deskriptor odkazuje sam na sebe, takze ring plni dokola bez CPU.
+//    Preruseni LDMA (DONE) jen pocita obehy - z nich se pozna preteceni ringu,
+//    kdyz TIMER1 stoji (vysilani) nebo nestiha.
+#define EDGE_RING_SIZE  64                  // musi pokryt hrany mezi dvema TIMER1 tiky
+static volatile uint32_t edge_ring[EDGE_RING_SIZE];
+static LDMA_Descriptor_t edge_desc;
+static uint16_t edge_tail = 0;              // dalsi nezpracovana znacka
+static uint32_t edge_consumed = 0;          // celkem zpracovanych (a zahozenych) znacek
+static volatile uint32_t edge_wraps = 0;    // obehy LDMA pres edge_ring
+static uint32_t edge_overruns = 0;          // zahozene obsahy ringu
+static volatile bool edge_sync = false;     // true = hrany synchronizuji fazi TIMER1
 
 void initInputs(void) {
     CMU_ClockEnable(cmuClock_GPIO, true);
@@ -29,8 +49,78 @@ void initInputs(void) {
     /* PA4 - Tamper vstup s pull-down */
     GPIO_PinModeSet(TAMPER_PORT,    TAMPER_PIN,    gpioModeInputPullFilter, 0);
 
-    // Povolen NVIC pro extern peruen
-    NVIC_EnableIRQ(GPIO_EVEN_IRQn); // PA0 je na sudm kanlu
+    initRXCapture();
+}
+
+//------------------------------------------------------------------------------
+// Zachytavani hran RX do WTIMER0 CC0 pres PRS, casove znacky odnasi LDMA
+// WTIMER0 musi bezet (initWTIMER0), LDMA musi byt inicializovano (LDMA_Init).
+//------------------------------------------------------------------------------
+static void initRXCapture(void) {
+    CMU_ClockEnable(cmuClock_PRS, true);
+
+    //-- PA0 na PRS: EXTI vyber pinu bez povoleni preruseni
+    GPIO_ExtIntConfig(RX_PORT, RX_PIN, RX_PIN, false, false, false);
+    GPIO_IntDisable(1 << RX_PIN);
+    PRS_SourceAsyncSignalSet(EDGE_PRS_CH, PRS_CH_CTRL_SOURCESEL_GPIOL, PRS_CH_CTRL_SIGSEL_GPIOPIN0);
+
+    //-- WTIMER0 CC0 zachyti CNT pri kazde hrane
+    TIMER_InitCC_TypeDef cc = TIMER_INITCC_DEFAULT;
+    cc.mode      = timerCCModeCapture;
+    cc.edge      = timerEdgeBoth;
+    cc.eventCtrl = timerEventEveryEdge;
+    cc.prsInput  = true;
+    cc.prsSel    = EDGE_TIMER_PRSSEL;
+    TIMER_InitCC((TIMER_TypeDef *)WTIMER0, 0, &cc);
+
+    //-- LDMA: CC0 -> edge_ring[], dokola, bez preruseni
+    edge_desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&WTIMER0->CC[0].CCV, edge_ring, EDGE_RING_SIZE, 0);
+    edge_desc.xfer.size    = ldmaCtrlSizeWord;
+    edge_desc.xfer.doneIfs = 1;             // obeh ringu -> Input_EdgeLdmaIrq()
+    LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_WTIMER0_CC0);
+    LDMA_StartTransfer(LDMA_CH_EDGE, &cfg, &edge_desc);
+
+    edge_tail = 0;
+    edge_consumed = 0;
+    edge_wraps = 0;
+}
+
+//------------------------------------------------------------------------------
+// Pozice zapisu LDMA v edge_ring a celkovy pocet zachycenych znacek
+//------------------------------------------------------------------------------
+static uint16_t edge_head(void) {
+    return (uint16_t)((LDMA->CH[LDMA_CH_EDGE].DST - (uint32_t)edge_ring) / 4) % EDGE_RING_SIZE;
+}
+
+static uint32_t edge_total(uint16_t head) {
+    uint32_t total = edge_wraps * EDGE_RING_SIZE + head;
+    //-- Obeh, jehoz preruseni LDMA jeste neprobehlo (vyssi priorita TIMER1)
+    if ((int32_t)(total - edge_consumed) < 0) total += EDGE_RING_SIZE;
+    return total;
+}
+
+//------------------------------------------------------------------------------
+// Zahodi nezpracovane znacky - po vysilani, pri re-armu a na zacatku preamble
+// se stare hrany nesmi michat s novymi
+//------------------------------------------------------------------------------
+void Input_EdgeResync(void) {
+    uint16_t head = edge_head();
+    edge_consumed = edge_total(head);
+    edge_tail = head;
+}
+
+uint32_t Input_EdgeOverruns(void) {
+    return edge_overruns;
+}
+
+//------------------------------------------------------------------------------
+// Obeh LDMA pres edge_ring - z LDMA_IRQHandler
+//------------------------------------------------------------------------------
+void Input_EdgeLdmaIrq(uint32_t pending) {
+    if (pending & (1UL << LDMA_CH_EDGE)) {
+        LDMA_IntClear(1UL << LDMA_CH_EDGE);
+        edge_wraps++;
+    }
 }
 
 uint32_t Input_GetRX(void)         { return GPIO_PinInGet(RX_PORT,        RX_PIN);        }
@@ -38,34 +128,89 @@ uint32_t Input_GetOnBattery(void)  { return GPIO_PinInGet(ONBATTERY_PORT, ONBATT
 uint32_t Input_GetTamper(void)     { return GPIO_PinInGet(TAMPER_PORT,    TAMPER_PIN);    }
 
 //------------------------------------------------------------------------------
-// GPIO preruseni od PA0 - detekce hrany POCSAG signalu
+// Zpracuje nove casove znacky hran RX - volano z TIMER1_IRQHandler
+// Nahrazuje puvodni GPIO_EVEN_IRQHandler: hrany uz nevyvolavaji preruseni,
+// znacky jsou z hardwaroveho capture a nezavisi na latenci preruseni.
 //------------------------------------------------------------------------------
-void GPIO_EVEN_IRQHandler(void) {
-    uint32_t flags = GPIO_IntGet();
-    GPIO_IntClear(flags);
-
-    if (flags & (1 << RX_PIN)) {
-    	if (calib_start) {
-//            TIMER_CounterSet((TIMER_TypeDef *)WTIMER0, 0); // Nuluje counter
-    		calib_start_counter = TIMER_CounterGet((TIMER_TypeDef *)WTIMER0);
+void Input_ProcessEdges(void) {
+    uint16_t head  = edge_head();
+    uint32_t total = edge_total(head);
+
+    //-- Ring pretekl - stare a nove znacky nejdou od sebe, zahodi se vse
+    //   (vcetne rozpracovane kalibrace, jeji hrana mohla byt prepsana)
+    if (total - edge_consumed >= EDGE_RING_SIZE) {
+        edge_overruns++;
+        edge_consumed = total;
+        edge_tail = head;
+        Input_CalibCancel();
+        return;
+    }
+
+    while (edge_tail != head) {
+        uint32_t ts = edge_ring[edge_tail];
+        edge_tail = (edge_tail + 1) % EDGE_RING_SIZE;
+        edge_consumed++;
+
+    	//-- Kalibrace se vaze na prvni hranu zachycenou az po snimku WTIMER0,
+    	//   starsi znacky v ringu se preskoci (rozdily bez znamenka, WTIMER0 bezi dokola)
+    	if (calib_start && (int32_t)(ts - calib_start_snap) >= 0) {
+    		calib_start_counter = ts;
     		calib_start = false;
+    		calib_started = true;
     	}
 
-		if (calib_stop) {
-			calib_stop_counter = TIMER_CounterGet((TIMER_TypeDef *)WTIMER0);
-			calib_count_per_bit = (calib_stop_counter-calib_start_counter)/calib_bits;
+		if (calib_stop && (int32_t)(ts - calib_stop_snap) >= 0) {
 			calib_stop = false;
-            TIMER1_Calibrate(calib_count_per_bit);
+			if (calib_started && calib_bits != 0) {
+				calib_stop_counter = ts;
+				calib_count_per_bit = (calib_stop_counter-calib_start_counter)/calib_bits;
+				TIMER1_Calibrate(calib_count_per_bit);
+			}
+			calib_started = false;
 		}
 
-		POCSAG_edge_detected();
+		if (edge_sync) {
+			POCSAG_edge_detected(ts);
+		}
+		else {
+			POCSAG_edge_track(ts);  // behem prijmu dat jen doladeni rychlosti
+		}
     }
 }
 
-void rx_edge_irq_enabled(void) {
-	GPIO_IntEnable(1 << RX_PIN);
+//------------------------------------------------------------------------------
+// Kalibrace rychlosti z preamble - volano z POCSAG_sample_bit() (TIMER1 ISR).
+// Zacatek a konec se snimkuje z volne beziciho WTIMER0, Input_ProcessEdges()
+// pak vezme prvni zachycenou hranu po snimku.
+//------------------------------------------------------------------------------
+void Input_CalibStart(void) {
+	calib_start_snap = WTIMER0->CNT;
+	calib_started = false;
+	calib_stop = false;
+	calib_start = true;
+}
+
+void Input_CalibStop(uint16_t bits) {
+	calib_bits = bits;
+	calib_stop_snap = WTIMER0->CNT;
+	calib_start = false;     // bez hrany od zacatku neni z ceho pocitat
+	calib_stop = true;
+}
+
+void Input_CalibCancel(void) {
+	calib_start = false;
+	calib_stop = false;
+	calib_started = false;
+}
+
+//------------------------------------------------------------------------------
+// Povoli / zakaze synchronizaci faze TIMER1 hranami RX
+// (pri zakazane se hrany pouziji pro sledovani rychlosti)
+//------------------------------------------------------------------------------
+void rx_edge_sync_on(void) {
+	edge_sync = true;
 }
 
-void rx_edge_irq_disabled(void) {
-	GPIO_IntDisable(1 << RX_PIN);
+void rx_edge_sync_off(void) {
+	edge_sync = false;
 }
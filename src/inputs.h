@@ -21,7 +21,14 @@ uint32_t Input_GetRX(void);
 uint32_t Input_GetOnBattery(void);
 uint32_t Input_GetTamper(void);
 
-void rx_edge_irq_enabled(void);
-void rx_edge_irq_disabled(void);
+void Input_ProcessEdges(void);   // volano z TIMER1_IRQHandler
+void Input_CalibStart(void);      // detekce preamble - snimek WTIMER0
+void Input_CalibStop(uint16_t bits);  // konec preamble po bits bitech
+void Input_CalibCancel(void);
+void Input_EdgeResync(void);      // zahodi nezpracovane hrany (re-arm, zacatek preamble)
+void Input_EdgeLdmaIrq(uint32_t pending);  // z LDMA_IRQHandler
+uint32_t Input_EdgeOverruns(void);
+void rx_edge_sync_on(void);       // hrany RX synchronizuji fazi TIMER1
+void rx_edge_sync_off(void);      // hrany RX jen pro sledovani rychlosti
 
 #endif /* INPUTS_H */
@@ -18,24 +18,26 @@
 #include "em_cmu.h"
 #include "em_gpio.h"
 #include "em_usart.h"
+#include "em_ldma.h"
 
 #include "ports.h"
 #include "parameters.h"
 #include "timer0.h"
 #include "timer1.h"
+#include "timer2.h"
 #include "led.h"
 #include "inputs.h"
-#include "usart0.h"
-#include "uart0.h"
-#include "uart1.h"
+#include "serial.h"
+#include "hostlink.h"
+#include "tci.h"
 #include "pocsag.h"
+#include "bch.h"
 #include "wtimer0.h"
+#if POCSAG_TX_USART
+#include "txsync.h"
+#endif
 
 
-//------------------------------------------------------------------------------
-//  Globalni promenne
-//------------------------------------------------------------------------------
-
 //------------------------------------------------------------------------------
 //  Init procesoru
 //------------------------------------------------------------------------------
@@ -73,6 +75,12 @@ static void initOutputs(void)
 	GPIO_PinOutSet(PTT_PORT, PTT_PIN);
 }
 
+static void initDMA(void)
+{
+    LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+    LDMA_Init(&ldmaInit);
+}
+
 static void delay_ms(uint32_t ms)
 {
     volatile uint32_t i;
@@ -92,15 +100,19 @@ int main(void)
 
     initClocks();  	/* MUSI BYT PRVNI */
 
-    initInputs();
+    initDMA();      // pred UART - vysilani UART pouziva LDMA
     initOutputs();
     initLED();
-    initUSART0();
-    initUART0();
-    initUART1();
+    TCI_Init();     // COM-B = prikazovy radek
+    initSerial();   // COM-A/B/C
     initTIMER0();
     initTIMER1();
+    initTIMER2();
     initWTIMER0();
+#if POCSAG_TX_USART
+    initTXSYNC();
+#endif
+    initInputs();   // capture hran RX potrebuje bezici WTIMER0 a LDMA
 
     //----------------- Blikačka
     LED1_On(); delay_ms(300); LED1_Off();
@@ -111,6 +123,8 @@ int main(void)
     LED_TX_On(); delay_ms(300); LED_TX_Off();
 
     Parameters_Init();
+    HOST_Init();    // prevezme port podle param.host_port
+    BCH_Init();
     POCSAG_rx_init();
 
     for (volatile int i = 0; i < 100000; i++);
@@ -133,69 +147,15 @@ int main(void)
     	POCSAG_process(); // Zpracuje a vypíše datagram, pokud je připraven
 
     	//------------------------------------------------------------------------------
-    	//  Prikaz z COM-B (UART1)
+    	//  Prijate davky z COM-A/B/C (LDMA + RX timeout)
     	//------------------------------------------------------------------------------
-    	if (tci_cmd != 0)
-    	{
-    		switch (tci_cmd)
-    		{
-    		case 'h' : 	sendStringUART1("help\r\n");
-    					sendStringUART1(" --------------------------------\r\n");
-    					sendStringUART1(" TCI commands:\r\n");
-    					sendStringUART1(" --------------------------------\r\n");
-    					sendStringUART1(" 1..6 : Toggle LED\r\n");
-    					sendStringUART1(" t : start TX TOKEN\r\n");
-    					sendStringUART1(" T : stop timer1 1200Hz\r\n");
-    					sendStringUART1(" x : GPIO_IntEnable(RX_PIN)\r\n");
-    					sendStringUART1(" p : show parameters\r\n");
-    					sendStringUART1(" h : display this help\r\n");
-    					sendStringUART1(" --------------------------------\r\n");
-    					POCSAG_show_rx_state();
-    					sendStringUART1(" --------------------------------\r\n");
-						break;
-
-    		case 'p' : 	Parameters_Show();
-    					break;
-
-    		case '1' : 	LED1_Toggle();
-    	    			GPIO_PinOutToggle(DBG_PORT, DBG_PIN);
-    					sendStringUART1("LED1");
-    					break;
-    		case '2' : 	LED2_Toggle();
-    					sendStringUART1("LED2");
-    					break;
-    		case '3' : 	LED3_Toggle();
-    					sendStringUART1("LED3");
-    					break;
-    		case '4' : 	LED4_Toggle();
-    					sendStringUART1("LED4");
-    					break;
-    		case '5' : 	LED_RX_Toggle();
-    					sendStringUART1("LED RX");
-    					break;
-    		case '6' : 	LED_TX_Toggle();
-    					sendStringUART1("LED TX");
-    					break;
-
-    		case 't' : 	tx_start();
-    					sendStringUART1("Tx datagram\r\n");
-    					break;
-
-    		case 'T' : 	TIMER1_Stop();
-    					sendStringUART1("Stop timer1 TX 1200Hz\r\n");
-    					break;
-
-    		case 'x' : 	sendStringUART1("TX toggle bit\r\n");
-//    					GPIO_PinOutToggle(TX_PORT, TX_PIN);
-    					rx_edge_irq_enabled();
-    					break;
-
-    		default:	break;
-    		}
+    	Serial_Poll();
+    	HOST_Poll();
 
-    		sendStringUART1("\r\nTCI> ");
-    		tci_cmd=0;
-    	}
+    	//------------------------------------------------------------------------------
+    	//  Prikazove radky z COM-B (UART1)
+    	//------------------------------------------------------------------------------
+    	TCI_Process();
 
     	//------------------------------------------------------------------------------
     	//  Akce 1x za vterinu
@@ -206,6 +166,15 @@ int main(void)
     		routing_handler();
     		sendStringUART1(".");
 
+    		//-- Kontrola nejhorsi doby obsluhy TIMER1 (rozpocet TIMER1_ISR_BUDGET_PCT)
+    		if (TIMER1_IsrOverBudget()) {
+    			char txt[80];
+    			sprintf(txt, "\r\n!!! TIMER1 ISR %lu cyc > %u%% z %lu cyc\r\n",
+    			        (unsigned long)TIMER1_IsrMax(), TIMER1_ISR_BUDGET_PCT, (unsigned long)TIMER1_Period());
+    			sendStringUART1(txt);
+    			TIMER1_IsrMaxReset();
+    		}
+
     		/*
     		if (Input_GetOnBattery()) {
 				sendStringUART1("Batery:1  ");
@@ -2,7 +2,7 @@
 //#include <stdint.h>
 //#include <stdbool.h>
 #include "parameters.h"
-#include "uart1.h"
+#include "serial.h"
 
 tci_parameters param;
 
@@ -19,6 +19,11 @@ void Parameters_Init(void) {
 	param.pretime = 0;
 	param.deadtime = 0;
 	param.sys_tok = 0;
+	param.sync_err = 2;
+	param.tx_rate = 0;
+	param.preamble = 576;
+	param.preamble_adapt = 0;
+	param.host_port = 0;
 
 	for (n=0; n<MAX_NETS; n++) {
 		param.netdau[n] = 0;
@@ -56,12 +61,30 @@ void Parameters_Show(void) {
 	sendStringUART1(txt);
 	sprintf(txt,"ERROR RPT: %u\r\n",param.error_rpt);
 	sendStringUART1(txt);
-	sprintf(txt,"PRETIME  : %u\r\n",param.pretime);
+	sprintf(txt,"PRETIME  : %lu us\r\n",param.pretime);
 	sendStringUART1(txt);
-	sprintf(txt,"DEADTIME : %u\r\n",param.deadtime);
+	sprintf(txt,"DEADTIME : %lu us\r\n",param.deadtime);
 	sendStringUART1(txt);
 	sprintf(txt,"SYS.TOK  : %u\r\n",param.sys_tok);
 	sendStringUART1(txt);
+	sprintf(txt,"SYNC ERR : %u\r\n",param.sync_err);
+	sendStringUART1(txt);
+	if (param.tx_rate != 0) {
+		sprintf(txt,"TX RATE  : %u\r\n",param.tx_rate);
+	}
+	else {
+		sprintf(txt,"TX RATE  : RX\r\n");
+	}
+	sendStringUART1(txt);
+	sprintf(txt,"PREAMBLE : %u%s\r\n",param.preamble,param.preamble_adapt ? " ADAPT" : "");
+	sendStringUART1(txt);
+	if (param.host_port != 0) {
+		sprintf(txt,"HOST PORT: COM%u\r\n",param.host_port);
+	}
+	else {
+		sprintf(txt,"HOST PORT: -\r\n");
+	}
+	sendStringUART1(txt);
 
 	sendStringUART1("-------------------------------------------------\r\nNET:");
 	for (n=0; n<MAX_NETS; n++) {
@@ -114,9 +137,25 @@ void Parameters_Show(void) {
 
 //------------------------------------------------------------------------------
 // Podle parametru NET,PATH,DAU nacte z route table a nastavi promenou route
+// Plati prvni radek, ktery souhlasi (PATH/DAU 255 = libovolna hodnota),
+// tabulka konci prvnim radkem s path == 0. Bez shody puvodni pevna routa.
 //------------------------------------------------------------------------------
 void make_route(unsigned char net, unsigned char path, unsigned char dau)
 {
+	unsigned char n = 0;
+
+	while ((n<MAX_ROUTES)&&(param.route[n].path!=0)) {
+		if ((param.route[n].net==net)
+		 && (param.route[n].path==255 || param.route[n].path==path)
+		 && (param.route[n].dau==255  || param.route[n].dau==dau)) {
+			route.follow = param.route[n].follow;
+			route.error  = param.route[n].error;
+			route.revers = param.route[n].revers;
+			return;
+		}
+		n++;
+	}
+
 	route.follow = 5;
 	route.error  = 2;
 	route.revers = 2;
@@ -21,9 +21,14 @@ typedef struct {
 	unsigned char next_time;
 	unsigned char next_rpt;
 	unsigned char error_rpt;
-	unsigned char pretime;
-	unsigned char deadtime;
+	unsigned long pretime;      // us od zaklicovani PTT do prvniho bitu (TIMER2, krok ~14 us)
+	unsigned long deadtime;     // us od posledniho bitu do odklicovani PTT
 	unsigned char sys_tok;
+	unsigned char sync_err;     // max. pocet chybnych bitu v FS (0..POCSAG_SYNC_ERR_MAX)
+	unsigned short tx_rate;     // rychlost vysilani 512/1200/2400, 0 = jako prijaty token
+	unsigned short preamble;    // delka preamble v bitech (128..576, po 32)
+	unsigned char preamble_adapt; // 1 = zkracovat preamble spolehlivym sousedum
+	unsigned char host_port;    // binarni protokol (hostlink.c): 0 = vypnuto, 1 = COM-A, 3 = COM-C
 	unsigned char netdau[MAX_NETS];
 	tci_routes    route[MAX_ROUTES];
 } tci_parameters;
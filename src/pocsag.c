@@ -5,12 +5,21 @@
 #include "pocsag.h"
 #include "parameters.h"
 #include "inputs.h"
-#include "uart1.h"
+#include "serial.h"
+#include "em_device.h"
 #include "em_timer.h"
 #include "em_gpio.h"
 #include "ports.h"
 #include "led.h"
 #include "timer1.h"
+#include "bch.h"
+#include "pocsag_msg.h"
+#include "timer2.h"
+#include "timer0.h"
+#include "hostlink.h"
+#if POCSAG_TX_USART
+#include "txsync.h"
+#endif
 
 typedef enum {
     STATE_RX_IDLE,      // Čekání na preamble v šumu
@@ -25,18 +34,135 @@ static volatile POCSAG_Rx_State rx_state = STATE_RX_IDLE;
 static volatile uint32_t shiftReg = 0;
 static volatile uint16_t bitCounter = 0;
 POCSAG_token rx_token;
-static uint32_t bitBuffer = 0;
-static uint8_t bitsInBuffer = 0;
+
+//--- Fronta prijatych slov a udalosti z TIMER1_IRQHandler do hlavni smycky.
+//    Zapisuje jen ISR (head), cte jen POCSAG_process() (tail) - bez zakazu preruseni.
+//    ISR nic nevypisuje, vsechny vypisy formatuje hlavni smycka z polozek fronty.
+//    Konec vysilani zapisuje TIMER1, TIMER2 (PTT dobeh) nebo TXC preruseni USART,
+//    vzdy jen jedno z nich - TIMER1 v te dobe uz stoji.
+#define RX_FIFO_SIZE  64                // mocnina 2, 64 slov = cca 1.7s pri 1200bps
+#define RX_FIFO_MASK  (RX_FIFO_SIZE - 1)
+
+typedef enum {
+    RXW_START,      // nalezen prvni FS, zacina token
+    RXW_WORD,       // datove slovo
+    RXW_SYNC,       // FS na zacatku dalsiho batch
+    RXW_END,        // konec tokenu
+    RXW_RATE,       // perioda bitu v tikach 72MHz (za RXW_START a pred RXW_END)
+    RXW_TX_END,     // konec vysilani, word = pocet vyslanych bitu
+    RXW_TIME        // WTIMER0 pri prvnim FS (za RXW_START), volne bezici
+} POCSAG_Rx_Item;
+
+//--- U RXW_START a RXW_SYNC nese word vzdalenost FS, u RXW_START i polaritu
+//    a v hornich 16 bitech rychlost prijmu (bps)
+#define RXW_SYNC_DIST(w)    ((w) & 0xFF)
+#define RXW_SYNC_INVERTED   0x100
+#define RXW_START_BPS(w)    ((uint16_t)((w) >> 16))
+
+typedef struct {
+    uint32_t word;
+    uint8_t  type;  // POCSAG_Rx_Item
+} rx_fifo_item;
+
+static rx_fifo_item rx_fifo[RX_FIFO_SIZE];
+static volatile uint16_t rx_fifo_head = 0;
+static volatile uint16_t rx_fifo_tail = 0;
+static volatile uint16_t rx_fifo_lost = 0;  // pocet zahozenych polozek (plna fronta)
+static uint16_t rx_words = 0;               // pocet slov aktualniho tokenu (ISR)
+static uint8_t  rx_invert = 0;              // 1 = prijem s obracenou polaritou
+static bool     rx_skip_sample = false;     // hrana tesne pred tikem, tik se nevzorkuje
+
+//--- Statistika synchronizace (FS)
+static volatile uint32_t sync_found = 0;    // pocet nalezenych FS
+static volatile uint32_t sync_fixed = 0;    // z toho s chybnymi bity
+static volatile uint8_t  sync_dist_max = 0; // nejvetsi prijata vzdalenost
+
+//--- Stav prubezneho zpracovani v hlavni smycce
+static bool rx_in_token = false;
+static bool rx_hdr_ok = false;
+
+//--- Zpravy prijateho tokenu (10 batch x 16 CW x 20 bitu = max. 457 znaku)
+#define RX_MSG_MAX   16
+static char rx_msg_text[512];
+static POCSAG_msg rx_msgs[RX_MSG_MAX];
+static POCSAG_decoder rx_dec;
+
+static void rx_token_end(void);
+static void rx_bit(uint8_t bit);
+static void rx_fifo_put(uint8_t type, uint32_t word);
+static void tx_bits_start(void);
+static void tx_bits_end(void);
+static void tx_finish(void);
+
+#if POCSAG_RX_OVERSAMPLE == 0
+//--- Sledovani bitove rychlosti behem celeho tokenu (PI smycka z hran dat).
+//    Kalibrace z preamble nastavi TOP, smycka ho pak doladuje, aby drift
+//    vysilace nerozjel vzorkovani v poslednich batch dlouheho tokenu.
+#define TRACK_KP_SHIFT  2    // faze: posun vzorku o 1/4 chyby hrany
+#define TRACK_KI_SHIFT  6    // perioda: zmena o 1/64 chyby hrany
+static uint32_t track_period = 0;  // perioda bitu v 1/256 tiku (Q8)
+#endif
+
+//--- Detekce rychlosti z rozestupu hran v preamble (jen v STATE_RX_IDLE).
+//    Preamble 1010... ma hranu na kazdem bitu, rychlost se prepne az po
+//    RATE_DETECT_EDGES po sobe jdoucich rozestupech odpovidajicich jedne rychlosti.
+#define RATE_DETECT_EDGES  16
+static const uint16_t rx_rates[] = { 512, 1200, 2400 };
+#define RX_RATES  (sizeof(rx_rates) / sizeof(rx_rates[0]))
+static uint32_t rate_last_edge = 0;
+static uint8_t  rate_cand = 0;
+static uint8_t  rate_count = 0;
+static uint16_t rx_last_bps = POCSAG_BPS_DEFAULT;  // rychlost posledniho prijateho tokenu
+
+#if POCSAG_RX_OVERSAMPLE
+//--- DPLL prijmu s prevzorkovanim. Faze bitu 0..2^32: 0 = hranice bitu, 2^31 = stred.
+#define DPLL_STEP      (uint32_t)(0x100000000ULL / POCSAG_RX_OVERSAMPLE)  // nominalni krok na vzorek
+#define DPLL_KP_SHIFT  2     // proporcionalni cast: 1/4 fazove chyby hrany
+#define DPLL_KI_SHIFT  12    // integracni cast: doladeni kroku (frekvence)
+#define DPLL_I_LIMIT   (int32_t)(DPLL_STEP / 32)  // max. korekce kroku +/-3%
+
+static uint32_t dpll_phase = 0;
+static int32_t  dpll_integ = 0;
+static uint8_t  dpll_last = 0;     // predchozi vzorek (detekce hrany)
+static uint8_t  vote_ones = 0;     // pocet jednicek ve stredni polovine bitu
+static uint8_t  vote_count = 0;    // pocet vzorku ve stredni polovine bitu
+static uint8_t  vote_center = 0;   // vzorek nejbliz stredu bitu (pri rovnosti hlasu)
+static bool     vote_center_ok = false;
+#endif
 
 typedef enum {
     STATE_TX_IDLE, 	// Nic nedela, ceka az bude vysilat
-    TX_PREAMBLE, 	// Vysila preamble
-    TX_SYNC,  		// Vysila FS - synchronizacni slovo
-    TX_CDW,  		// Vysila codeword - datove slovo
+    TX_PRETIME, 	// Zaklicovano, ceka na nabeh vysilace (param.pretime)
+    TX_STREAM, 		// Vysila pripraveny bitovy proud (preamble, FS, CW)
+    TX_DEADTIME, 	// Odvysilano, drzi PTT jeste param.deadtime
 } POCSAG_Tx_State;
 static POCSAG_Tx_State tx_state = STATE_TX_IDLE;
-static volatile uint16_t number_of_tx = 0;    // Pocet vyslanych bitu
-static volatile uint16_t number_of_words = 0; // Pocet vyslanych slov CDW
+
+//--- Cely vysilany proud bitu, pripravi ho tx_start() - ISR jen posouva masku.
+//    Bity jdou od MSB kazdeho slova: preamble (param.preamble), pred kazdou batch FS.
+#define TX_STREAM_BITS    (POCSAG_PREAMBLE_MAX + MAX_BATCHES * (1 + WORDS_PER_BATCH) * 32)
+static uint32_t tx_stream[TX_STREAM_BITS / 32];
+static const uint32_t *tx_ptr;             // aktualni slovo proudu
+static uint32_t tx_mask;                   // aktualni bit ve slove
+static volatile uint16_t tx_bits_left = 0; // zbyva vyslat bitu
+static uint16_t tx_bits_total = 0;         // delka proudu v bitech
+
+//--- Prepnuti TX -> RX. Perioda prijmu se pred vysilanim ulozi a po nem jen
+//    vrati (kalibrace z posledni preamble zustava). Doba od posledniho bitu
+//    do pripraveneho prijmu se meri v taktech CPU (DWT CYCCNT, 72MHz).
+static uint32_t rx_period_saved = 0;       // perioda TIMER1 prijmu pred vysilanim
+static uint32_t tx_end_cycles = 0;         // CYCCNT po poslednim bitu
+static volatile uint32_t turnaround_last = 0;  // posledni bit -> prijem (takty, vc. deadtime)
+static volatile uint32_t turnaround_max = 0;
+static volatile uint32_t rearm_max = 0;        // vlastni prepnuti prijmu (takty)
+
+//--- Adaptivni preamble (param.preamble_adapt). Soused, ktery token potvrdi
+//    hned na prvni pokus POCSAG_PREAMBLE_LOCKS krat za sebou, dostane preamble
+//    o POCSAG_PREAMBLE_STEP kratsi (az na POCSAG_PREAMBLE_MIN). Kazde opakovani
+//    mu vrati plnou delku param.preamble.
+static uint16_t preamble_dau[32];          // delka pro adresata (DAU 0..31), 0 = param.preamble
+static uint8_t  preamble_locks[32];        // potvrzeni na prvni pokus v rade
+static bool     route_retried = false;     // route_token uz byl opakovan
 
 typedef enum {
     STATE_ROUTE_IDLE,  // Nic nedela, ceka az bude vysilat
@@ -49,7 +175,26 @@ static POCSAG_Route_State route_state = STATE_ROUTE_IDLE;
 static uint32_t route_repeat_counter = 0;
 static uint32_t route_timer = 0;
 
-POCSAG_token tx_token;
+POCSAG_token tx_token;       // prave vysilany token (tx_serialize)
+static POCSAG_token route_token;  // token cekajici na potvrzeni (opakovani, chybova cesta)
+
+//--- Fronta tokenu k vysilani. Vysila se, az je kanal i vysilac volny,
+//    nejdriv systemove tokeny, pak opakovani, pak nove tokeny (v poradi prijeti).
+#define TX_QUEUE_SIZE  4
+
+typedef struct {
+    POCSAG_token token;
+    uint32_t     seq;    // poradi zarazeni
+    uint8_t      prio;   // POCSAG_TXQ_xxx
+    bool         used;
+} tx_queue_item;
+
+static tx_queue_item tx_queue[TX_QUEUE_SIZE];
+static uint32_t tx_queue_seq = 0;
+static uint8_t  tx_queue_depth = 0;
+static uint8_t  tx_queue_depth_max = 0;
+static uint32_t tx_queue_sent = 0;
+static uint32_t tx_queue_drops[POCSAG_TXQ_PRIOS];  // zahozene podle priority
 
 // --- BCH (31,21) a Parita ---
 // Pomocná funkce pro zrcadlení bitů v 32-bitovém slově
@@ -62,125 +207,340 @@ __attribute__((unused)) static uint32_t reverse32(uint32_t x) {
 }
 
 //------------------------------------------------------------------------------
-// Vrací jeden bit z 32bitov0ho slova. 1=nejnizsi bit .. 32=nejvyzsi bit.
+// Init prijmu
+//------------------------------------------------------------------------------
+static void rx_reset(void) {
+    rx_state = STATE_RX_IDLE;
+    rx_words = 0;  // rx_token patri hlavni smycce, plni ho POCSAG_process()
+	tx_state = STATE_TX_IDLE;
+	shiftReg = 0;
+#if POCSAG_RX_OVERSAMPLE
+	dpll_phase = 0;
+	dpll_integ = 0;
+	vote_ones = 0;
+	vote_count = 0;
+	vote_center_ok = false;
+#endif
+
+	Input_CalibCancel();
+
+    // Hrany PA0 zachytava WTIMER0 (initInputs), povolime jejich vyhodnoceni
+    rx_edge_sync_on();
+}
+
+//------------------------------------------------------------------------------
+// Init prijmu - po startu, vcetne TIMER1
+//------------------------------------------------------------------------------
+void POCSAG_rx_init(void) {
+    rx_reset();
+
+    // Timer1 na vychozi hodnoty
+    initTIMER1();
+    TIMER1_Start();  // citac pobezi trvale
+}
+
+//------------------------------------------------------------------------------
+// Rychly navrat na prijem po vysilani - jen stavovy automat a perioda TIMER1,
+// hodiny, NVIC ani detekce hran se znovu nenastavuji
+//------------------------------------------------------------------------------
+static void rx_rearm(void) {
+    uint32_t start = DWT->CYCCNT;
+
+    rx_reset();
+    Input_EdgeResync();  // hrany z doby vysilani nepatri k prijmu
+    TIMER1_RxSpeed(rx_period_saved);
+    TIMER1_Start();
+
+    uint32_t now = DWT->CYCCNT;
+    turnaround_last = now - tx_end_cycles;
+    if (turnaround_last > turnaround_max) turnaround_max = turnaround_last;
+    if (now - start > rearm_max) rearm_max = now - start;
+}
+
+//------------------------------------------------------------------------------
+// Detekce rychlosti - rozestup hran porovna s periodou bitu 512/1200/2400 bps
+// (+/-10%). Pri shode RATE_DETECT_EDGES rozestupu za sebou prepne prijem.
+//------------------------------------------------------------------------------
+static void rate_detect(uint32_t timestamp) {
+    uint32_t d = timestamp - rate_last_edge;
+    uint8_t  r;
+
+    rate_last_edge = timestamp;
+    for (r = 0; r < RX_RATES; r++) {
+        uint32_t p = TIMER1_BIT_TICKS(rx_rates[r]);
+        if (d > p - p / 10 && d < p + p / 10) break;
+    }
+    if (r >= RX_RATES) {
+        rate_count = 0;
+        return;
+    }
+    if (r != rate_cand) {
+        rate_cand = r;
+        rate_count = 0;
+    }
+    if (++rate_count >= RATE_DETECT_EDGES) {
+        rate_count = 0;
+        if (rx_rates[r] != TIMER1_Rate()) {
+            TIMER1_SetRate(rx_rates[r]);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Rychlost vysilani - z parametru, nebo podle posledniho prijateho tokenu
+//------------------------------------------------------------------------------
+static uint16_t tx_rate(void) {
+    if (param.tx_rate != 0) return param.tx_rate;
+    return rx_last_bps;
+}
+
+//------------------------------------------------------------------------------
+// Synchro na hranu signalu - Voláno z Input_ProcessEdges() v TIMER1_IRQHandler
+// timestamp = WTIMER0 v okamziku hrany (hardwarovy capture)
 //------------------------------------------------------------------------------
-uint8_t get_bit(uint32_t word, uint8_t bit_pos) {
-    // Kontrola rozsahu (povolené hodnoty 1 až 32)
-    if (bit_pos < 1 || bit_pos > 32) {
-        return 0;
+void POCSAG_edge_detected(uint32_t timestamp) {
+    if (rx_state == STATE_RX_IDLE) {
+        rate_detect(timestamp);
     }
 
-    // Výpočet posunu:
-    // Pro bit_pos = 32 chceme posun o 31 (nejvyšší bit)
-    // Pro bit_pos = 1 chceme posun o 0 (nejnižší bit)
-    uint8_t shift = bit_pos - 1;
+//    if (rx_state != STATE_RECEIVING)
+//    if (rx_state == STATE_RX_IDLE)
+    {
+#if POCSAG_RX_OVERSAMPLE == 0
+		// Nastavime časovač tak, jako by byl v okamžiku hrany na polovině periody,
+		// aby Sample přišel do středu bitu. Hrana je zpracována až v TIMER1 tiku,
+		// proto se přičte doba uplynulá od hrany (oba časovače běží na 72MHz).
+		// Pokud hrana byla méně než půl bitu před tímto tikem, tento tik by
+		// vzorkoval těsně za hranou -> vynechá se (stejně jako dřív reset CNT).
+        uint32_t period  = TIMER1_Period();
+        uint32_t elapsed = (TIMER_CounterGet((TIMER_TypeDef *)WTIMER0) - timestamp) % period;
+        TIMER1_SetCount((period / 2 + elapsed) % period);
+        rx_skip_sample = (elapsed < period / 2);
+#else
+        (void)timestamp;
+#endif
+        // Pri prevzorkovani fazi vede DPLL, hrana slouzi jen pro kalibraci
+        LED_TX_On();
+    }
+}
 
-    // Izolace bitu pomocí masky a posunu
-    if (word & (1UL << shift)) {
-        return 1;
-    } else {
-        return 0;
+//------------------------------------------------------------------------------
+// Sledovani rychlosti z hran dat - volano z Input_ProcessEdges() misto
+// POCSAG_edge_detected(), kdyz je synchronizace hranou vypnuta.
+// Hranice bitu ma lezet v polovine periody TIMER1 (vzorek je ve stredu bitu).
+// Pri prevzorkovani sleduje rychlost DPLL, tady se nedela nic.
+//------------------------------------------------------------------------------
+void POCSAG_edge_track(uint32_t timestamp) {
+#if POCSAG_RX_OVERSAMPLE == 0
+    if (rx_state != STATE_RECEIVING) return;
+
+    uint32_t period  = TIMER1_Period();
+    uint32_t now     = TIMER1_Count();
+    uint32_t elapsed = (TIMER_CounterGet((TIMER_TypeDef *)WTIMER0) - timestamp) % period;
+
+    //-- Chyba = kde byl TIMER1 v okamziku hrany proti polovine periody
+    int32_t err = (int32_t)((now + period - elapsed) % period) - (int32_t)(period / 2);
+    int32_t lim = (int32_t)(period / 8);   // ruseni nesmi smycku rozhodit
+    if (err >  lim) err =  lim;
+    if (err < -lim) err = -lim;
+
+    //-- Perioda: hrana pozde = vysilac pomalejsi -> delsi perioda
+    uint32_t nominal = TIMER1_Nominal();
+    int32_t p = (int32_t)track_period + err * (256 >> TRACK_KI_SHIFT);
+    if (p < (int32_t)(TIMER1_CALIB_MIN(nominal) * 256)) p = (int32_t)(TIMER1_CALIB_MIN(nominal) * 256);
+    if (p > (int32_t)(TIMER1_CALIB_MAX(nominal) * 256)) p = (int32_t)(TIMER1_CALIB_MAX(nominal) * 256);
+    track_period = (uint32_t)p;
+    TIMER1_SetPeriod((track_period + 128) >> 8);
+
+    //-- Faze: hrana pozde = vzorkujeme brzy -> dalsi vzorek oddalit.
+    //   Oddaleni o vic nez uplynulo od preteceni = pristi tik se vynecha.
+    int32_t corr = err >> TRACK_KP_SHIFT;
+    if (corr > (int32_t)now) {
+        TIMER1_SetCount(now + TIMER1_Period() - (uint32_t)corr);
+        rx_skip_sample = true;
+    }
+    else {
+        TIMER1_SetCount((uint32_t)((int32_t)now - corr));
     }
+#else
+    (void)timestamp;
+#endif
 }
 
-static uint32_t calculate_syndrom(uint32_t word) {
-    // POCSAG používá pro výpočet syndromu bity v pořadí, jak přicházely.
-    // Musíme pracovat s bity od MSB k LSB (bit 31 je x^30).
+//------------------------------------------------------------------------------
+// Aktualni perioda bitu v tikach 72MHz (odhad prijimace)
+//------------------------------------------------------------------------------
+static uint32_t rx_bit_period(void) {
+#if POCSAG_RX_OVERSAMPLE
+    //-- Vzorku na bit = 2^32 / (krok DPLL)
+    return (uint32_t)(((uint64_t)TIMER1_Period() << 32) / (uint32_t)(DPLL_STEP + dpll_integ));
+#else
+    return TIMER1_Period();
+#endif
+}
 
-    // Vytvoříme pracovní kopii a vynulujeme paritu (bit 0)
-    uint32_t reg = word & 0xFFFFFFFE;
+//------------------------------------------------------------------------------
+// Delka preamble pro adresata - zaokrouhlena na cela slova a omezena
+//------------------------------------------------------------------------------
+static uint16_t preamble_clamp(uint16_t bits) {
+    bits &= ~31;
+    if (bits < POCSAG_PREAMBLE_MIN) bits = POCSAG_PREAMBLE_MIN;
+    if (bits > POCSAG_PREAMBLE_MAX) bits = POCSAG_PREAMBLE_MAX;
+    return bits;
+}
 
-    // Polynom: x^10 + x^9 + x^8 + x^6 + x^5 + x^3 + 1  => 0b11101101001 => 0x769
-    // Pro dělení shora (od bitu 31) musíme polynom zarovnat doleva:
-    // 0x769 zarovnaný tak, aby x^10 odpovídalo bitu 31:
-    uint32_t poly = 0xED200000; // To je 0x769 posunutý tak, aby začínal na bitu 31
+static uint16_t tx_preamble_bits(uint8_t adr) {
+    uint16_t bits = param.preamble;
 
-    for (int i = 0; i < 21; i++) {
-        if (reg & (1UL << (31 - i))) {
-            reg ^= (poly >> i);
-        }
+    if (param.preamble_adapt && preamble_dau[adr & 0x1F] != 0 && preamble_dau[adr & 0x1F] < bits) {
+        bits = preamble_dau[adr & 0x1F];
     }
-    // Syndrom jsou bity 10 až 1. Pokud je slovo OK, musí být tyto bity v reg nulové.
-    return (reg & 0x000007FE);
+    return preamble_clamp(bits);
 }
 
-static bool check_parity(uint32_t word) {
-    // Celkové slovo (32 bitů) má mít SUDOU paritu
-    uint32_t p = 0;
-    for (int i = 0; i < 32; i++) {
-        if (word & (1UL << i)) p++;
+//------------------------------------------------------------------------------
+// Adresat potvrdil token na prvni pokus - po nekolika v rade zkrati preamble
+// Pri vypnute adaptaci se nic neuci - po zapnuti se zacina od plne delky.
+//------------------------------------------------------------------------------
+static void preamble_locked(uint8_t adr) {
+    if (!param.preamble_adapt) return;
+    adr &= 0x1F;
+    if (++preamble_locks[adr] < POCSAG_PREAMBLE_LOCKS) return;
+
+    preamble_locks[adr] = 0;
+    uint16_t bits = tx_preamble_bits(adr);
+    if (bits - POCSAG_PREAMBLE_STEP >= POCSAG_PREAMBLE_MIN) {
+        preamble_dau[adr] = bits - POCSAG_PREAMBLE_STEP;
     }
-    return (p % 2 == 0);
 }
-static uint32_t try_fix_word(uint32_t word, bool *fixed) {
-    *fixed = false;
 
-    // 1. Krok: Je slovo už v pořádku?
-    if (calculate_syndrom(word) == 0 && check_parity(word)) {
-        return word;
+//------------------------------------------------------------------------------
+// Adresat token nepotvrdil - zpet na plnou delku
+//------------------------------------------------------------------------------
+static void preamble_missed(uint8_t adr) {
+    if (!param.preamble_adapt) return;
+    adr &= 0x1F;
+    preamble_locks[adr] = 0;
+    preamble_dau[adr] = 0;
+}
+
+//------------------------------------------------------------------------------
+// Pripravi cely vysilany proud z tx_token - vraci pocet bitu
+//------------------------------------------------------------------------------
+static uint16_t tx_serialize(void) {
+    uint16_t n = 0;
+
+    //-- Preamble 1010..., zacina jednickou
+    for (uint16_t i = 0; i < tx_preamble_bits(tx_token.adr) / 32; i++) {
+        tx_stream[n++] = 0xAAAAAAAA;
     }
 
-    // 2. Krok: Pokus o opravu jednoho bitu (brute force přes všech 32 pozic)
-    for (int i = 0; i < 32; i++) {
-        uint32_t test_word = word ^ (1UL << i);
-        if (calculate_syndrom(test_word) == 0 && check_parity(test_word)) {
-            *fixed = true;
-            return test_word;
+    //-- Pred kazdou batch FS, pak az 16 CW
+    for (uint16_t w = 0; w < tx_token.total_words && w < MAX_BATCHES * WORDS_PER_BATCH; w++) {
+        if (w % WORDS_PER_BATCH == 0) {
+            tx_stream[n++] = POCSAG_SYNC_WORD;
         }
+        tx_stream[n++] = tx_token.data[w];
     }
-
-    return word; // Neopravitelné (více chyb)
+    return n * 32;
 }
 
 //------------------------------------------------------------------------------
-// Init prijmu
+// Volne misto ve fronte pro token s prioritou prio. Pri plne fronte se uvolni
+// nejnovejsi polozka s nizsi prioritou, jinak se novy token zahodi (NULL).
 //------------------------------------------------------------------------------
-void POCSAG_rx_init(void) {
-    rx_state = STATE_RX_IDLE;
-    rx_token.ready = false;
-    rx_token.total_words = 0;
-	tx_state = STATE_TX_IDLE;
-	shiftReg = 0;
+static POCSAG_token *tx_queue_slot(uint8_t prio) {
+    tx_queue_item *slot = NULL;
 
-	calib_start = false;
-	calib_stop = false;
-//	calib_start_counter = 0;
-//	calib_stop_counter = 0;
+    for (uint8_t i = 0; i < TX_QUEUE_SIZE; i++) {
+        if (!tx_queue[i].used) {
+            slot = &tx_queue[i];
+            break;
+        }
+    }
 
-    // Povolení přerušení od hran PA0
-    GPIO_ExtIntConfig(RX_PORT, RX_PIN, RX_PIN, true, true, true);
-    rx_edge_irq_enabled();
+    if (slot == NULL) {
+        //-- Obet: nejnizsi priorita, z ni nejnovejsi
+        tx_queue_item *victim = &tx_queue[0];
+        for (uint8_t i = 1; i < TX_QUEUE_SIZE; i++) {
+            if (tx_queue[i].prio > victim->prio ||
+                (tx_queue[i].prio == victim->prio && tx_queue[i].seq > victim->seq)) {
+                victim = &tx_queue[i];
+            }
+        }
+        if (victim->prio <= prio) {
+            tx_queue_drops[prio]++;
+            return NULL;
+        }
+        tx_queue_drops[victim->prio]++;
+        slot = victim;
+        tx_queue_depth--;
+    }
 
-    // Timer1 na vychozi hodnoty
-    initTIMER1();
-    TIMER1_Start();  // citac pobezi trvale
+    slot->used = true;
+    slot->prio = prio;
+    slot->seq = tx_queue_seq++;
+    tx_queue_depth++;
+    if (tx_queue_depth > tx_queue_depth_max) tx_queue_depth_max = tx_queue_depth;
+    return &slot->token;
 }
 
 //------------------------------------------------------------------------------
-// Synchro na hranu signalu - Voláno z GPIO_EVEN_IRQHandler
+// Zaradi hotovy token (s BCH) do fronty k vysilani
 //------------------------------------------------------------------------------
-void POCSAG_edge_detected(void) {
-//    if (rx_state != STATE_RECEIVING)
-//    if (rx_state == STATE_RX_IDLE)
-    {
-		// Resetujeme časovač na polovinu periody, aby první Sample přišel do středu bitu
-        TIMER1->CNT = TIMER1_TOP / 2;
-        LED_TX_On();
+bool POCSAG_tx_queue(const POCSAG_token *token, uint8_t prio) {
+    POCSAG_token *t = tx_queue_slot(prio);
+    if (t == NULL) {
+        sendStringUART1("TXQ: token zahozen\r\n");
+        return false;
     }
+    *t = *token;
+    return true;
 }
 
 //------------------------------------------------------------------------------
-// Nastavi TX BIT
+// Posledni vysilany token znovu - prikaz 't'. Jde pres frontu, takze neprerusi
+// probihajici vysilani ani PTT pretime/deadtime a respektuje priority.
 //------------------------------------------------------------------------------
-void set_tx_bit(uint8_t bit) {
-	if (bit==1) {
-		GPIO_PinOutSet(TX_PORT, TX_PIN);
-		sendStringUART1("1");
-	}
-	else {
-		GPIO_PinOutClear(TX_PORT, TX_PIN);
-		sendStringUART1("0");
-	}
+bool POCSAG_tx_repeat(void) {
+    if (tx_token.total_words < 3) return false;   // zatim nic nevysilano
+    return POCSAG_tx_queue(&tx_token, POCSAG_TXQ_NORMAL);
+}
+
+//------------------------------------------------------------------------------
+// Zahodi z fronty vsechny tokeny dane priority (potvrzeny token se neopakuje)
+//------------------------------------------------------------------------------
+static void tx_queue_purge(uint8_t prio) {
+    for (uint8_t i = 0; i < TX_QUEUE_SIZE; i++) {
+        if (tx_queue[i].used && tx_queue[i].prio == prio) {
+            tx_queue[i].used = false;
+            tx_queue_depth--;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Spusti dalsi token z fronty, pokud se neprijima ani nevysila - main loop
+//------------------------------------------------------------------------------
+static void tx_queue_service(void) {
+    tx_queue_item *next = NULL;
+
+    if (tx_queue_depth == 0) return;
+    if (rx_state != STATE_RX_IDLE || tx_state != STATE_TX_IDLE) return;
+
+    for (uint8_t i = 0; i < TX_QUEUE_SIZE; i++) {
+        if (!tx_queue[i].used) continue;
+        if (next == NULL || tx_queue[i].prio < next->prio ||
+            (tx_queue[i].prio == next->prio && tx_queue[i].seq < next->seq)) {
+            next = &tx_queue[i];
+        }
+    }
+
+    tx_token = next->token;
+    next->used = false;
+    tx_queue_depth--;
+    tx_queue_sent++;
+    tx_start();
 }
 
 //------------------------------------------------------------------------------
@@ -191,9 +551,10 @@ void tx_start(void) {
 
 	LED2_On();
 
-	//-- Zastavit a zablokovat Rx
+	//-- Zastavit a zablokovat Rx, perioda prijmu se po vysilani vrati
 	TIMER1_Stop();
-	rx_edge_irq_disabled(); // Vypneme detekci hran - nevyhodnocuje prijem
+	rx_period_saved = TIMER1_Period();
+	rx_edge_sync_off(); // Vypneme synchronizaci hranami - nevyhodnocuje prijem
 //    GPIO_IntDisable(1 << RX_PIN); // VYPNEME HRANY - nevyhodnocuje prijem
 	rx_state = STATE_TRANSMITING;
 
@@ -212,13 +573,43 @@ void tx_start(void) {
     sendStringUART1(buf);
 	sprintf(buf,"FOLLOW=%u ERROR=%u REVERSAL=%02u\r\n",route.follow, route.error, route.revers);
     sendStringUART1(buf);
+	sprintf(buf,"RATE=%u bps PREAMBLE=%u PTT pre=%luus dead=%luus\r\n", tx_rate(), tx_preamble_bits(tx_token.adr), param.pretime, param.deadtime);
+    sendStringUART1(buf);
 
-	//-- Spusti vysilani
-	tx_state = TX_PREAMBLE;
-	number_of_tx = 0;
-	GPIO_PinOutClear(TX_PORT, TX_PIN);    	// nula aby preamble zacal 1
+	//-- Pripravi proud a zaklicuje, bity se spusti az po nabehu vysilace
+	tx_bits_total = tx_serialize();
+	tx_bits_left = tx_bits_total;
+	tx_ptr = tx_stream;
+	tx_mask = 0x80000000;
+	tx_state = TX_PRETIME;
+	GPIO_PinOutClear(TX_PORT, TX_PIN);    	// klidovy stav do prvniho bitu
 	GPIO_PinOutClear(PTT_PORT, PTT_PIN);  	// zaklicuje
-	TIMER1_ResetSpeed();
+
+	if (param.pretime != 0) {
+		TIMER2_OneShot(param.pretime);  // pokracuje POCSAG_ptt_timer()
+	}
+	else {
+		tx_bits_start();
+	}
+}
+
+//------------------------------------------------------------------------------
+//  Start vlastnich bitu - po PTT predstihu
+//------------------------------------------------------------------------------
+static void tx_bits_start(void) {
+	tx_state = TX_STREAM;
+
+#if POCSAG_TX_USART
+	if (TXSYNC_Supported(tx_rate())) {
+		//-- LDMA posila bajty po rade, USART je vysila MSB napred
+		for (uint16_t i = 0; i < tx_bits_left / 32; i++) {
+			tx_stream[i] = __REV(tx_stream[i]);
+		}
+		TXSYNC_Start((const uint8_t *)tx_stream, tx_bits_left / 8, tx_rate());
+		return;  // TIMER1 stoji, konec ohlasi POCSAG_tx_done()
+	}
+#endif
+	TIMER1_TxSpeed(tx_rate());
 	TIMER1_Start();
 }
 
@@ -230,70 +621,208 @@ void tx_stop(void) {
 	GPIO_PinOutSet(PTT_PORT, PTT_PIN);  	// odklicuje
 	LED2_Off();
 	LED3_Off();
-	POCSAG_rx_init();  // inicializuje prijem
-	rx_state = STATE_RX_IDLE;
+	rx_rearm();  // zpet na prijem
+}
+
+//------------------------------------------------------------------------------
+//  Odvysilan posledni bit - PTT jeste drzi po dobu param.deadtime
+//------------------------------------------------------------------------------
+static void tx_bits_end(void) {
+	TIMER1_Stop();
+	tx_end_cycles = DWT->CYCCNT;
+	tx_state = TX_DEADTIME;
+
+	if (param.deadtime != 0) {
+		TIMER2_OneShot(param.deadtime);  // pokracuje POCSAG_ptt_timer()
+	}
+	else {
+		tx_finish();
+	}
+}
+
+//------------------------------------------------------------------------------
+//  Konec vysilani - odklicuje a ohlasi konec hlavni smycce
+//------------------------------------------------------------------------------
+static void tx_finish(void) {
+	rx_fifo_put(RXW_TX_END, tx_bits_total);
+	tx_stop();
+}
+
+//------------------------------------------------------------------------------
+// Uplynul cas PTT - volano z TIMER2_IRQHandler
+//------------------------------------------------------------------------------
+void POCSAG_ptt_timer(void) {
+	if (tx_state == TX_PRETIME) {
+		tx_bits_start();
+	}
+	else if (tx_state == TX_DEADTIME) {
+		tx_finish();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Konec vysilani pres USART - volano z TXC preruseni (txsync.c)
+//------------------------------------------------------------------------------
+void POCSAG_tx_done(void) {
+    tx_bits_end();
 }
 
 //------------------------------------------------------------------------------
 // Vysila BIT - Voláno z sample_bit() spoustenym z TIMER1_IRQHandler (1200 Hz)
+// Jen dalsi bit z pripraveneho proudu. Vysilani konci az tik po poslednim
+// bitu, aby i posledni bit mel celou delku.
 //------------------------------------------------------------------------------
-void tx_bit(void) {
-    switch (tx_state) {
-        case STATE_TX_IDLE:
-        	break;
-        case TX_PREAMBLE:
-			//-- Vysila
-			number_of_tx++;
-			GPIO_PinOutToggle(TX_PORT, TX_PIN);
-			if (number_of_tx == 576) {  //-- preamble ma 576 bitu
-				number_of_tx = 0;
-				number_of_words = 0;
-				tx_state = TX_SYNC;
-				sendStringUART1("\n");
-			}
-        	break;
-        case TX_SYNC:
-        	number_of_tx++;
-        	set_tx_bit(get_bit(POCSAG_SYNC_WORD, 33-number_of_tx));  //-- Nastavi TX BIT
-			if (number_of_tx == 32) {  //-- 32 bitu sync word
-				number_of_tx = 0;
-				tx_state = TX_CDW;
-				sendStringUART1("\n");
-			}
-        	break;
-        case TX_CDW:
-        	number_of_tx++;
-        	set_tx_bit(get_bit(tx_token.data[number_of_words], 33-number_of_tx));  //-- Nastavi TX BIT
-			if (number_of_tx == 32) {  //-- 32 bitu = vyslano cele slovo
-				number_of_tx = 0;
-				number_of_words++;
-				sendStringUART1("\n");
-				if(number_of_words >= tx_token.total_words) {  //-- vyslan cely token
-					tx_stop();
-					sendStringUART1("--------------------------------\n");
-					sendStringUART1("TxEND\n");
-				}
-				else {
-					if(number_of_words%16 == 0) {  //-- konec batch nasleduje SYNC WORD
-						number_of_tx = 0;
-						tx_state = TX_SYNC;
-						sendStringUART1("\n");
-					}
-				}
-			}
-        	break;
+static void tx_bit(void) {
+    if (tx_state != TX_STREAM) return;
+
+    if (tx_bits_left == 0) {
+        tx_bits_end();
+        return;
     }
+
+    if (*tx_ptr & tx_mask) GPIO_PinOutSet(TX_PORT, TX_PIN);
+    else                   GPIO_PinOutClear(TX_PORT, TX_PIN);
+
+    tx_mask >>= 1;
+    if (tx_mask == 0) {
+        tx_mask = 0x80000000;
+        tx_ptr++;
+    }
+    tx_bits_left--;
 }
 
 //------------------------------------------------------------------------------
-// Odecte nebo vysila BIT - Voláno z TIMER1_IRQHandler (1200 Hz)
+// Pocet jednickovych bitu ve slove
+//------------------------------------------------------------------------------
+static uint32_t popcount32(uint32_t x) {
+    x = x - ((x >> 1) & 0x55555555);
+    x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+    x = (x + (x >> 4)) & 0x0F0F0F0F;
+    return (x * 0x01010101) >> 24;
+}
+
+//------------------------------------------------------------------------------
+// Korelace se synchronizacnim slovem (Hammingova vzdalenost)
+// Vraci vzdalenost <= param.sync_err, jinak -1. Pokud je povolena obracena
+// polarita (inverted != NULL), zkusi i negovane FS a vysledek vrati v *inverted.
+//------------------------------------------------------------------------------
+static int8_t sync_match(uint32_t word, uint8_t *inverted) {
+    uint32_t d = popcount32(word ^ POCSAG_SYNC_WORD);
+    uint32_t limit = (param.sync_err > POCSAG_SYNC_ERR_MAX) ? POCSAG_SYNC_ERR_MAX : param.sync_err;
+
+    if (d <= limit) {
+        if (inverted) *inverted = 0;
+        return (int8_t)d;
+    }
+    if (inverted && (32 - d) <= limit) {  // ~FS ma vzdalenost 32-d
+        *inverted = 1;
+        return (int8_t)(32 - d);
+    }
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+// Zapocte nalezene FS do statistiky
+//------------------------------------------------------------------------------
+static void sync_stat(int8_t dist) {
+    sync_found++;
+    if (dist > 0) sync_fixed++;
+    if (dist > sync_dist_max) sync_dist_max = (uint8_t)dist;
+}
+
+//------------------------------------------------------------------------------
+// Vlozi polozku do fronty - volano jen z TIMER1_IRQHandler
+//------------------------------------------------------------------------------
+static void rx_fifo_put(uint8_t type, uint32_t word) {
+    uint16_t head = rx_fifo_head;
+    uint16_t next = (head + 1) & RX_FIFO_MASK;
+
+    if (next == rx_fifo_tail) {
+        rx_fifo_lost++;  // hlavni smycka nestiha
+        return;
+    }
+    rx_fifo[head].word = word;
+    rx_fifo[head].type = type;
+    __DMB();              // rx_fifo[] neni volatile - data pred indexem
+    rx_fifo_head = next;  // az po zapisu dat
+}
+
+#if POCSAG_RX_OVERSAMPLE
+//------------------------------------------------------------------------------
+// Jeden vzorek RX pri prevzorkovani - vetsinove hlasovani a DPLL
+// Vraci 0/1 pri dokonceni bitu, jinak -1
+//------------------------------------------------------------------------------
+static int8_t rx_oversample(void) {
+    uint8_t  s  = (Input_GetRX() > 0) ? 1 : 0;
+    uint32_t ph = dpll_phase;
+    int32_t  corr = 0;
+    int8_t   bit = -1;
+
+    //-- Hrana ma lezet na hranici bitu (faze 0). Faze za hranou = hodiny jdou
+    //   napred -> zpomalit, faze pred hranou (zaporna) = zpozdeni -> zrychlit.
+    if (s != dpll_last) {
+        dpll_last = s;
+        int32_t err = (int32_t)ph;
+        dpll_integ -= err >> DPLL_KI_SHIFT;
+        if (dpll_integ >  DPLL_I_LIMIT) dpll_integ =  DPLL_I_LIMIT;
+        if (dpll_integ < -DPLL_I_LIMIT) dpll_integ = -DPLL_I_LIMIT;
+        corr = err >> DPLL_KP_SHIFT;
+    }
+
+    //-- Hlasuji jen vzorky ze stredni poloviny bitu (faze 1/4 .. 3/4)
+    if (ph >= 0x40000000UL && ph < 0xC0000000UL) {
+        vote_count++;
+        vote_ones += s;
+        if (!vote_center_ok && ph >= 0x80000000UL) {
+            vote_center = s;
+            vote_center_ok = true;
+        }
+    }
+
+    //-- Preteceni faze = konec bitu
+    uint64_t next = (uint64_t)ph + DPLL_STEP + dpll_integ - corr;
+    if (next >> 32) {
+        if (vote_ones * 2 > vote_count)      bit = 1;
+        else if (vote_ones * 2 < vote_count) bit = 0;
+        else                                 bit = vote_center;
+        vote_ones = 0;
+        vote_count = 0;
+        vote_center_ok = false;
+    }
+    dpll_phase = (uint32_t)next;
+    return bit;
+}
+#endif
+
+//------------------------------------------------------------------------------
+// Odecte nebo vysila BIT - Voláno z TIMER1_IRQHandler
+// (1200 Hz, pri prevzorkovani prijmu N x 1200 Hz)
 //------------------------------------------------------------------------------
 void POCSAG_sample_bit(void) {
-    char buf[160];
+    if (rx_state == STATE_TRANSMITING) {
+        tx_bit();
+        return;
+    }
+
+#if POCSAG_RX_OVERSAMPLE
+    int8_t bit = rx_oversample();
+    if (bit >= 0) rx_bit((uint8_t)bit);
+#else
+    if (rx_skip_sample) {
+        rx_skip_sample = false;    // tik tesne za hranou, dalsi prijde do stredu bitu
+        return;
+    }
+    rx_bit((Input_GetRX() > 0) ? 1 : 0);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Zpracovani jednoho prijateho bitu - stavovy automat prijmu
+//------------------------------------------------------------------------------
+static void rx_bit(uint8_t bit) {
     static uint8_t wordsInBatch = 0; // Sleduje pozici v rámci aktuálního batche (0-15)
 
-	uint8_t bit = (Input_GetRX() > 0) ? 1 : 0;
-    shiftReg = (shiftReg << 1) | bit;
+    shiftReg = (shiftReg << 1) | (bit ^ rx_invert);
 
     GPIO_PinOutToggle(DBG_PORT, DBG_PIN);
     //LED2_Toggle();
@@ -306,13 +835,11 @@ void POCSAG_sample_bit(void) {
 			if ((shiftReg == 0xAAAAAAAA) || (shiftReg == 0x55555555)) {
 //			if ((uint16_t)(shiftReg & 0xFFFF) == 0xAAAA || (uint16_t)(shiftReg & 0xFFFF) == 0x5555) {
                 rx_state = STATE_PREAMBLE;
+                rx_invert = 0;  // preamble je symetricka, polaritu urci az FS
                 TIMER1_ResetSpeed();
                 bitCounter = 0;
-//            	calib_start_counter = 0;
-//            	calib_stop_counter = 0;
-                TIMER_CounterSet((TIMER_TypeDef *)WTIMER0, 0); // Nuluje counter
-            	calib_bits = 0;
-        		calib_start = true;
+                Input_EdgeResync();  // dal jen hrany od zacatku preamble
+                Input_CalibStart();  // WTIMER0 bezi volne, nenuluje se
             	LED1_On();
             }
             break;
@@ -323,21 +850,30 @@ void POCSAG_sample_bit(void) {
 			if ((shiftReg != 0xAAAAAAAA) && (shiftReg != 0x55555555)) {
 				//-- Zkusi nacist FS (sync.word)
                 rx_state = STATE_SYNC_WORD;
-                calib_bits = bitCounter;
-        		calib_stop = true;
+                Input_CalibStop(bitCounter);
                 bitCounter = 0;
-//                TIMER1_Calibrate(calib_stop_counter-calib_start_counter);
             }
             break;
 
 
-        case STATE_SYNC_WORD:
-            if (shiftReg == POCSAG_SYNC_WORD) {
+        case STATE_SYNC_WORD: {
+            uint8_t inv = 0;
+            int8_t dist = sync_match(shiftReg, &inv);
+            if (dist >= 0) {
                 rx_state = STATE_RECEIVING;
+                rx_invert = inv;  // dalsi bity se budou negovat
                 bitCounter = 0;
                 wordsInBatch = 1; // Dalších 16 slov jsou data
-                rx_token.total_words = 0;
-            	rx_edge_irq_disabled(); // Vypneme detekci hran - teď už jen pevný čas
+                rx_words = 0;
+                sync_stat(dist);
+                rx_fifo_put(RXW_START, (uint32_t)dist | (inv ? RXW_SYNC_INVERTED : 0)
+                                       | ((uint32_t)TIMER1_Rate() << 16));
+                rx_fifo_put(RXW_RATE, rx_bit_period());
+                rx_fifo_put(RXW_TIME, WTIMER0->CNT);
+#if POCSAG_RX_OVERSAMPLE == 0
+                track_period = TIMER1_Period() << 8;  // od kalibrace z preamble
+#endif
+            	rx_edge_sync_off(); // Vypneme synchronizaci hranami - teď už jen pevný čas
 //                GPIO_PinOutSet(DBG_PORT, DBG_PIN);
 
             }
@@ -350,12 +886,13 @@ void POCSAG_sample_bit(void) {
                 }
             }
             break;
+        }
 
 		case STATE_RECEIVING:
 			bitCounter++;
 			//-- Synchronizoval na prvni dva bity FS, zastavit
 			if (wordsInBatch == 0 && bitCounter == 2) {
-            	rx_edge_irq_disabled(); // Vypneme detekci hran - teď už jen pevný čas
+            	rx_edge_sync_off(); // Vypneme synchronizaci hranami - teď už jen pevný čas
 			}
 
 			if (bitCounter >= 32) {
@@ -368,29 +905,30 @@ void POCSAG_sample_bit(void) {
 
 				// SCÉNÁŘ A: Čekáme na SYNC slovo (každých 17. slovo v proudu dat)
 				if (wordsInBatch == 0) {
-					if (shiftReg == POCSAG_SYNC_WORD) {
+					int8_t dist = sync_match(shiftReg, NULL);  // polarita uz je dana
+					if (dist >= 0) {
 						// V pořádku, začíná další batch
+						sync_stat(dist);
+						rx_fifo_put(RXW_SYNC, (uint32_t)dist);
 						// wordsInBatch necháme na 0, ale nepíšeme SYNC do dat
 						// (Teoreticky zde wordsInBatch nastavíme na 1 po inkrementaci níže)
 					} else {
 						// KONEC DATAGRAMU: Na místě, kde měl být SYNC, je něco jiného
-						rx_token.ready = true;
+						rx_fifo_put(RXW_RATE, rx_bit_period());
+						rx_fifo_put(RXW_END, 0);
 						rx_state = STATE_RX_IDLE;
 //						TIMER1->CMD = TIMER_CMD_STOP;
-
-						sprintf(buf,"\r\nTIMER1.TOP=%lu",TIMER1->TOP);
-					    sendStringUART1(buf);
-
 						TIMER1_ResetSpeed();
-    					rx_edge_irq_enabled();
+    					rx_edge_sync_on();
 						return;
 					}
 				}
 
 				// SCÉNÁŘ B: Čteme datové slovo (1-16)
 				else {
-					if (rx_token.total_words < (MAX_BATCHES * WORDS_PER_BATCH)) {
-						rx_token.data[rx_token.total_words++] = shiftReg;
+					if (rx_words < (MAX_BATCHES * WORDS_PER_BATCH)) {
+						rx_fifo_put(RXW_WORD, shiftReg);
+						rx_words++;
 					}
 				}
 
@@ -399,34 +937,22 @@ void POCSAG_sample_bit(void) {
 				if (wordsInBatch > 16) {
 					wordsInBatch = 0; // Příští slovo MUSÍ být SYNC
 					//-- zrusena synchronizace na kazde FS - uz je kalibrovano
-//					rx_edge_irq_enabled();
+//					rx_edge_sync_on();
 				}
 
 				// Ochrana proti přetečení celkového pole
-				if (rx_token.total_words >= (MAX_BATCHES * WORDS_PER_BATCH)) {
-					rx_token.ready = true;
+				if (rx_words >= (MAX_BATCHES * WORDS_PER_BATCH)) {
+					rx_fifo_put(RXW_RATE, rx_bit_period());
+					rx_fifo_put(RXW_END, 0);
 					rx_state = STATE_RX_IDLE;
 //					TIMER1->CMD = TIMER_CMD_STOP;
 					TIMER1_ResetSpeed();
-					rx_edge_irq_enabled();
+					rx_edge_sync_on();
 				}
 			}
 			break;
 		case STATE_TRANSMITING:
-			tx_bit();
-/*
-			bitCounter--;
-			if (bitCounter == 0) {
-				//-- Konec vysilani
-				GPIO_PinOutSet(PTT_PORT, PTT_PIN);
-				POCSAG_Init();
-			}
-			else {
-				//-- Vysila
-				GPIO_PinOutToggle(TX_PORT, TX_PIN);
-			}
-*/
-			break;
+			break;  // vysilani obsluhuje primo POCSAG_sample_bit()
     }
 }
 
@@ -434,6 +960,35 @@ void POCSAG_sample_bit(void) {
 // Vypise stav rx_state na UART1 (COM-B)
 //------------------------------------------------------------------------------
 void POCSAG_show_rx_state(void) {
+	char buf[160];
+
+	sprintf(buf, " SYNC: found=%lu fixed=%lu max_dist=%u limit=%u\r\n",
+	        (unsigned long)sync_found, (unsigned long)sync_fixed, sync_dist_max, param.sync_err);
+	sendStringUART1(buf);
+	sprintf(buf, " TXQ: depth=%u max=%u sent=%lu drop sys/rty/new=%lu/%lu/%lu\r\n",
+	        tx_queue_depth, tx_queue_depth_max, (unsigned long)tx_queue_sent,
+	        (unsigned long)tx_queue_drops[POCSAG_TXQ_SYSTEM], (unsigned long)tx_queue_drops[POCSAG_TXQ_RETRY],
+	        (unsigned long)tx_queue_drops[POCSAG_TXQ_NORMAL]);
+	sendStringUART1(buf);
+	sendStringUART1(" PREAMBLE:");
+	for (uint8_t i = 0; i < 32; i++) {
+		if (preamble_dau[i] != 0) {
+			sprintf(buf, " %02u=%u", i, preamble_dau[i]);
+			sendStringUART1(buf);
+		}
+	}
+	sprintf(buf, " ostatni=%u%s\r\n", preamble_clamp(param.preamble),
+	        param.preamble_adapt ? "" : " (adaptace vypnuta)");
+	sendStringUART1(buf);
+	sprintf(buf, " TX->RX: last=%lu us max=%lu us (deadtime %lu us), prepnuti max=%lu cyc\r\n",
+	        (unsigned long)(turnaround_last / 72), (unsigned long)(turnaround_max / 72),
+	        param.deadtime, (unsigned long)rearm_max);
+	sendStringUART1(buf);
+	sprintf(buf, " HRANY RX: preteceni ringu=%lu\r\n", (unsigned long)Input_EdgeOverruns());
+	sendStringUART1(buf);
+	sprintf(buf, " TIMER1 ISR: max=%lu cyc, perioda=%lu cyc, limit=%u%%\r\n",
+	        (unsigned long)TIMER1_IsrMax(), (unsigned long)TIMER1_Period(), TIMER1_ISR_BUDGET_PCT);
+	sendStringUART1(buf);
 	sendStringUART1(" RX STATE: ");
     switch (rx_state) {
         case STATE_RX_IDLE:
@@ -467,112 +1022,40 @@ void POCSAG_show_rx_state(void) {
 	sendStringUART1("\r\n");
 }
 
-// Pomocná funkce pro dekódování 7-bit ASCII (upraveno pro korektní bit-order)
-void decode_ascii_part(uint32_t word, char *outStr) {
-    uint32_t data = (word >> 11) & 0xFFFFF; // 20 bitů dat
-
-    for (int i = 0; i < 20; i++) {
-        bitBuffer <<= 1;
-        if (data & (1UL << (19 - i))) bitBuffer |= 1;
-        bitsInBuffer++;
-
-        if (bitsInBuffer == 7) {
-            // POCSAG ASCII je LSB-first
-            uint8_t c = 0;
-            for(int b=0; b<7; b++) {
-                if(bitBuffer & (1 << b)) c |= (1 << (6-b));
-            }
-
-            if (c >= 32 && c <= 126) {
-                size_t len = strlen(outStr);
-                if (len < 120) {
-                    outStr[len] = (char)c;
-                    outStr[len+1] = '\0';
-                }
-            }
-            bitBuffer = 0;
-            bitsInBuffer = 0;
-        }
-    }
-}
-
 //------------------------------------------------------------------------------
 //  Vypocet BCH a PARITY
 //------------------------------------------------------------------------------
 /**
- * @brief Vypočítá BCH(31,21) a paritu pro všechna slova v tx_token.
- * Předpokládá, že v tx_token.data[i] je uloženo 21 informačních bitů
- * zarovnaných doleva (bity 31 až 11).
- * @brief Vypočítá BCH a paritu dle POCSAG standardu (včetně inverze kontrolních bitů).
- * Generuje správné IDLE slovo 0x7A89C197 z dat 0x7A89C...
+ * @brief Prepocita BCH(31,21) a paritu slov oznacenych v token->dirty.
+ * Data jsou v bitech 31..11, bity 10..1 = BCH, bit 0 = suda parita
+ * (generator 0x769, bez inverze kontrolnich bitu). Kodovani je tabulkove
+ * (BCH_Encode), neoznacena slova zustanou beze zmeny, IDLE slovo tez.
  */
 void make_bch(POCSAG_token *token) {
     if (token == NULL) return;
 
-    /*
-     * POCSAG BCH(31,21) + sudá parita
-     * ---------------------------------
-     * Každé 32-bitové slovo má strukturu:
-     *   bit 31..11 = 21 datových bitů (MSB první)
-     *   bit 10..1  = 10 BCH kontrolních bitů
-     *   bit 0      = paritní bit (sudá parita celého slova)
-     *
-     * Generátor: g(x) = x^10 + x^9 + x^8 + x^6 + x^5 + x^3 + 1 = 0x769
-     *
-     * Algoritmus:
-     *   1. Vezmi 21 datových bitů (bity 31..11 vstupního slova).
-     *   2. Sestav 31-bit codeword základ: data21 << 10  (bity 30..10).
-     *   3. Polynomiální dělení GF(2): odečítej generátor od MSB dolů.
-     *      Zbytek (bity 9..0) jsou BCH kontrolní bity.
-     *   4. Sestav výsledné 32-bit slovo: (data21 << 11) | (bch << 1).
-     *   5. Nastav bit 0 (paritu) tak aby byl celkový počet jedniček sudý.
-     *
-     * Chyby původní verze:
-     *   - Použití poly=0x1B5 (chybný generátor; správný je 0x769).
-     *   - Inverze reg ^= 0x3FF (POCSAG BCH inverzi NEPOŽADUJE).
-     *   - Počítání parity jen přes 31 bitů místo 32.
-     */
-
-    const uint32_t GEN = 0x769u;  /* generátor BCH(31,21) */
-
-    for (int i = 0; i < token->total_words; i++) {
-        uint32_t in = token->data[i];
-
-        /* IDLE slovo necháme beze změny */
-        if (in == POCSAG_IDLE_WORD) continue;
-
-        /* 1. Extrahuj 21 datových bitů */
-        uint32_t data21 = (in >> 11) & 0x1FFFFFu;
-
-        /* 2. Základ 31-bit codeword: data na pozicích 30..10 */
-        uint32_t cw = data21 << 10;
-
-        /* 3. Polynomiální dělení – odečítáme generátor od MSB dolů */
-        for (int b = 20; b >= 0; b--) {
-            if (cw & (1u << (b + 10))) {
-                cw ^= (GEN << b);
-            }
-        }
-        /* cw[9..0] = BCH zbytek (kontrolní bity) */
+    for (uint16_t n = 0; n < sizeof(token->dirty) / sizeof(token->dirty[0]); n++) {
+        uint32_t mask = token->dirty[n];
+        token->dirty[n] = 0;
 
-        /* 4. Sestav 32-bit slovo: data[31..11] | bch[10..1] | parita[0] */
-        uint32_t word = (data21 << 11) | ((cw & 0x3FFu) << 1);
+        while (mask != 0) {
+            uint16_t i = n * 32 + __builtin_ctz(mask);
+            mask &= mask - 1;
 
-        /* 5. Sudá parita přes všech 32 bitů */
-        uint32_t tmp = word;
-        uint8_t  par = 0;
-        while (tmp) { par ^= (uint8_t)(tmp & 1u); tmp >>= 1; }
-        if (par) word |= 1u;  /* nastav bit 0 aby byl počet jedniček sudý */
-
-        token->data[i] = word;
+            if (i >= token->total_words) break;
+            if (token->data[i] == POCSAG_IDLE_WORD) continue;
+            token->data[i] = BCH_Encode(token->data[i]);
+        }
     }
 }
 
 //------------------------------------------------------------------------------
 //  Z binární hlavičky v poli data[] nastavi všechny promnene ve struktuře
+//  Vraci false pokud je nektere slovo hlavicky neopravitelne (podle status[])
 //------------------------------------------------------------------------------
-void read_header(POCSAG_token *token) {
-    if (token == NULL) return;
+bool read_header(POCSAG_token *token) {
+    if (token == NULL) return false;
+    if (token->total_words < 3) return false;
 
     token->token_id = (token->data[2]>>16)&0x1F;
     token->batch= (token->data[1]>>25)&0x3F;
@@ -583,6 +1066,9 @@ void read_header(POCSAG_token *token) {
     token->master =(token->data[1]>>16)&0x1F;
     token->system_token = 0x01==((token->data[0]>>21)&0x07);
 
+    return (WORD_STATE(token->status[0]) != WORD_ERROR)
+        && (WORD_STATE(token->status[1]) != WORD_ERROR)
+        && (WORD_STATE(token->status[2]) != WORD_ERROR);
 }
 
 //------------------------------------------------------------------------------
@@ -619,7 +1105,29 @@ void make_header(POCSAG_token *token) {
     d2 |= ((uint32_t)(token->token_id     & 0x1F) << 16);
     token->data[2] = d2;
 
-	make_bch(&tx_token);     //-- Opravi BCH a Paritu
+	//-- Zmenila se jen hlavicka, ostatni slova uz maji platne BCH
+	POCSAG_MARK_DIRTY(token, 0);
+	POCSAG_MARK_DIRTY(token, 1);
+	POCSAG_MARK_DIRTY(token, 2);
+	make_bch(token);     //-- Opravi BCH a Paritu
+}
+
+//------------------------------------------------------------------------------
+// Token z nadrazeneho systemu (hostlink.c) - hlavicka z poli, BCH a parita
+// se prepocitaji u vsech slov, fronta dostane hotovy token.
+// Posledni neuplna batch se doplni IDLE slovy - tx_serialize() posila slova
+// tak jak jsou a batch musi mit vzdy 16 CW.
+//------------------------------------------------------------------------------
+bool POCSAG_tx_inject(POCSAG_token *token, uint8_t prio) {
+    while (token->total_words % WORDS_PER_BATCH != 0
+           && token->total_words < MAX_BATCHES * WORDS_PER_BATCH) {
+        token->data[token->total_words++] = POCSAG_IDLE_WORD;
+    }
+    for (uint16_t i = 0; i < token->total_words; i++) {
+        POCSAG_MARK_DIRTY(token, i);
+    }
+    make_header(token);
+    return POCSAG_tx_queue(token, prio);
 }
 
 //------------------------------------------------------------------------------
@@ -642,50 +1150,201 @@ void POCSAG_Tx_datagram(void) {
 */
 
 //------------------------------------------------------------------------------
-//  Zpracovani prijateho datagramu
+//  Kontrola a oprava vsech slov tokenu - vola se jednou po prijmu.
+//  Vysledek je v token->status[], dalsi zpracovani uz BCH nepocita.
 //------------------------------------------------------------------------------
-void POCSAG_process(void) {
-    if (!rx_token.ready) return;
+void POCSAG_validate(POCSAG_token *token) {
+    if (token == NULL) return;
 
-    char buf[160];
-    char textMsg[128] = {0};
-    bitBuffer = 0;
-    bitsInBuffer = 0;
+    token->rx_ok = true; // Neopravena chyba to pripadne schodi
+    token->fixed_words = 0;
+    token->error_words = 0;
 
-    sendStringUART1("\r\n--- RX POCSAG START ---\r\n");
+    for (uint16_t i = 0; i < token->total_words; i++) {
+        POCSAG_validate_word(token, i);
+    }
+}
+
+//------------------------------------------------------------------------------
+//  Kontrola a oprava jednoho slova tokenu, vysledek v token->status[i]
+//------------------------------------------------------------------------------
+void POCSAG_validate_word(POCSAG_token *token, uint16_t i) {
+    if (token->data[i] == POCSAG_IDLE_WORD) {
+        token->status[i] = WORD_OK;
+        return;
+    }
+
+    int8_t n = BCH_Correct(&token->data[i]);  // uloží opravenou hodnotu zpět
+    if (n < 0) {
+        token->status[i] = WORD_ERROR;
+        token->error_words++;
+        token->rx_ok = false;
+    }
+    else if (n > 0) {
+        token->status[i] = WORD_FIXED | (uint8_t)(n << 2);
+        token->fixed_words++;
+    }
+    else {
+        token->status[i] = WORD_OK;
+    }
+}
 
+//------------------------------------------------------------------------------
+//  Zacatek tokenu - vynuluje prijimany token a stav dekodovani
+//------------------------------------------------------------------------------
+static void rx_token_begin(uint32_t sync) {
+    rx_token.ready = false;
+    rx_token.sync_dist = RXW_SYNC_DIST(sync);
+    rx_token.inverted = (sync & RXW_SYNC_INVERTED) ? 1 : 0;
+    rx_token.bps = RXW_START_BPS(sync);
+    rx_token.total_words = 0;
+    memset(rx_token.dirty, 0, sizeof(rx_token.dirty));  // prijata slova jsou opravena
     rx_token.rx_ok = true; // Neopravena chyba to pripadne schodi
+    rx_token.fixed_words = 0;
+    rx_token.error_words = 0;
+    rx_token.period_start = 0;
+    rx_token.period_end = 0;
+    rx_token.rate_mHz = 0;
+    rx_token.drift_ppm = 0;
+    rx_token.fs_ticks = 0;
+    rx_token.uptime_s = SecondCounter;
+    rx_hdr_ok = false;
+    POCSAG_dec_init(&rx_dec, rx_msg_text, sizeof(rx_msg_text), rx_msgs, RX_MSG_MAX);
+    rx_in_token = true;
 
-    //--- Výpis surových dat a kontrola/oprava CDW
-    for (uint16_t i = 0; i < rx_token.total_words; i++) {
-        uint32_t raw = rx_token.data[i];
+    sendStringUART1("\r\n--- RX POCSAG START ---\r\n");
+}
 
-        if (raw == POCSAG_IDLE_WORD) {
-            sprintf(buf, "W[%02d]: IDLE\r\n", i+1);
-            sendStringUART1(buf);
-            continue;
-        }
+//------------------------------------------------------------------------------
+//  Zpracovani jednoho prijateho slova - oprava, vypis, hlavicka, zprava
+//------------------------------------------------------------------------------
+static void rx_token_word(uint32_t word) {
+    char buf[160];
 
-        bool fixed = false;
-        uint32_t clean = try_fix_word(raw, &fixed);
-        bool valid = (calculate_syndrom(clean) == 0 && check_parity(clean));
+    if (rx_token.total_words >= (MAX_BATCHES * WORDS_PER_BATCH)) return;
 
-        if (valid) {
-            rx_token.data[i] = clean;  // uložit opravenou hodnotu zpět
-        }
-        else {
-        	rx_token.rx_ok = false;
+    uint16_t i = rx_token.total_words++;
+    rx_token.data[i] = word;
+    POCSAG_validate_word(&rx_token, i);  //-- Jediny pruchod BCH, dale se cte jen status[]
+
+    //--- Výpis dat a stavu CDW
+    uint8_t st = rx_token.status[i];
+    if (rx_token.data[i] == POCSAG_IDLE_WORD) {
+        sprintf(buf, "W[%02d]: IDLE\r\n", i+1);
+    }
+    else if (WORD_STATE(st) == WORD_FIXED) {
+        sprintf(buf, "W[%02d]: %08X OK  [FIXED %u]\r\n",
+                i+1, (unsigned int)rx_token.data[i], WORD_FIXED_BITS(st));
+    }
+    else {
+        sprintf(buf, "W[%02d]: %08X %s\r\n",
+                i+1, (unsigned int)rx_token.data[i], (WORD_STATE(st) == WORD_OK) ? "OK " : "ERR");
+    }
+    sendStringUART1(buf);
+
+    //---------------------- Po tretim slove je hlavicka kompletni
+    if (i == 2) {
+        rx_hdr_ok = read_header(&rx_token);
+        return;
+    }
+
+    //--- Dekódování adresy a textu --- az od ctvrteho codewordu, za hlavickou
+    if (i < 3 || !rx_hdr_ok || rx_token.system_token != 0) return;
+
+    //-- Slovo je uz opravene v POCSAG_validate_word(), ramec = pozice v batch / 2
+    POCSAG_dec_word(&rx_dec, rx_token.data[i], (uint8_t)((i % 16) / 2), WORD_STATE(st) != WORD_ERROR);
+}
+
+//------------------------------------------------------------------------------
+//  Zpracovani prijateho datagramu - volano v main loop
+//  Slova se zpracovavaji prubezne jak prichazeji z fronty, po konci tokenu
+//  se vypise souhrn a rozhodne o routovani.
+//------------------------------------------------------------------------------
+void POCSAG_process(void) {
+    char buf[40];
+
+    while (rx_fifo_tail != rx_fifo_head) {
+        uint16_t tail = rx_fifo_tail;
+        uint8_t  type = rx_fifo[tail].type;
+        uint32_t word = rx_fifo[tail].word;
+        __DMB();                                   // cteni dat pred uvolnenim polozky
+        rx_fifo_tail = (tail + 1) & RX_FIFO_MASK;  // az po precteni dat
+
+        switch (type) {
+            case RXW_START:
+                if (rx_in_token) {
+                    rx_token.rx_ok = false;  // konec predchoziho se ztratil
+                    rx_token_end();
+                }
+                rx_token_begin(word);
+                break;
+
+            case RXW_SYNC:
+                if (rx_in_token && RXW_SYNC_DIST(word) > rx_token.sync_dist) {
+                    rx_token.sync_dist = RXW_SYNC_DIST(word);
+                }
+                break;
+
+            case RXW_WORD:
+                if (rx_in_token) rx_token_word(word);
+                break;
+
+            case RXW_END:
+                if (rx_in_token) rx_token_end();
+                break;
+
+            case RXW_RATE:
+                if (rx_in_token) {
+                    if (rx_token.period_start == 0) rx_token.period_start = word;
+                    rx_token.period_end = word;
+                }
+                break;
+
+            case RXW_TIME:
+                if (rx_in_token) rx_token.fs_ticks = word;
+                break;
+
+            case RXW_TX_END:
+                sprintf(buf, "TX bits=%lu\r\n", (unsigned long)word);
+                sendStringUART1("--------------------------------\n");
+                sendStringUART1(buf);
+                sprintf(buf, "TX->RX %lu us\r\n", (unsigned long)(turnaround_last / 72));
+                sendStringUART1(buf);
+                sendStringUART1("TxEND\n");
+                break;
         }
+    }
+
+    tx_queue_service();  //-- Dalsi token z fronty, jakmile je volno
+}
+
+//------------------------------------------------------------------------------
+//  Konec tokenu - souhrn a rozhodnuti o vysilani
+//------------------------------------------------------------------------------
+static void rx_token_end(void) {
+    char buf[160];
 
-        sprintf(buf, "W[%02d]: %08X %s %s\r\n",
-                i+1, (unsigned int)rx_token.data[i], valid ? "OK " : "ERR", fixed ? "[FIXED]" : "");
-//        sprintf(buf, "W[%02d]: %08X->%08X %s %s\r\n",
-//                i+1, (unsigned int)raw, (unsigned int)clean,
-//                valid ? "OK " : "ERR", fixed ? "[FIXED]" : "");
+    rx_in_token = false;
+    rx_token.ready = true;
+    rx_last_bps = rx_token.bps;
+
+    //--- Rychlost na konci tokenu a drift od kalibrace z preamble
+    if (rx_token.period_end != 0) {
+        rx_token.rate_mHz = (uint32_t)((72000000ULL * 1000) / rx_token.period_end);
+        rx_token.drift_ppm = (int32_t)(((int64_t)rx_token.period_start - rx_token.period_end) * 1000000
+                                       / (int64_t)rx_token.period_start);
+    }
+
+    if (rx_fifo_lost != 0) {
+        uint16_t lost = rx_fifo_lost;
+        sprintf(buf, "--- FIFO LOST %u ---\r\n", lost);
         sendStringUART1(buf);
+        __disable_irq();       // odecist vypsane, ISR mohlo mezitim pricist
+        rx_fifo_lost -= lost;
+        __enable_irq();
+        rx_token.rx_ok = false;
     }
 
-//    sendStringUART1("-----------------------------\r\n");
     if (rx_token.rx_ok) {
     	sprintf(buf, "--- OK: ");
     	LED3_On();
@@ -695,9 +1354,6 @@ void POCSAG_process(void) {
     }
     sendStringUART1(buf);
 
-	//---------------------- Nacte udaje z hlavicky
-    read_header(&rx_token);
-
     //--- Vypise hlavicku
 	if(rx_token.system_token==1) {
 		sendStringUART1("SYSTEM ");
@@ -709,74 +1365,32 @@ void POCSAG_process(void) {
     sendStringUART1(buf);
 	sprintf(buf,"TOKEN=%u BATCH=%u MASTER=%02u ",rx_token.token_id,rx_token.batch,rx_token.master);
     sendStringUART1(buf);
-//    sprintf(buf, "KALIBR:%lu\r\n",calib_count_per_bit);
     // Výpočet v milihertzech pomocí celých čísel
-    uint32_t freq_mHz = (72000000ULL * 1000) / calib_count_per_bit;
-    sprintf(buf, "f=%lu.%03luHz\r\n", freq_mHz / 1000, freq_mHz % 1000);
+    sprintf(buf, "RATE=%u f=%lu.%03luHz DRIFT=%ldppm SYNC=%u%s\r\n", rx_token.bps,
+            (unsigned long)(rx_token.rate_mHz / 1000), (unsigned long)(rx_token.rate_mHz % 1000),
+            (long)rx_token.drift_ppm, rx_token.sync_dist, rx_token.inverted ? " INV" : "");
     sendStringUART1(buf);
 
-    //--- Dekódování adresy a textu --- az od ctvrteho codewordu, za hlavickou
-    if (rx_token.rx_ok) {
-		if(rx_token.system_token==0) {
-//			sendStringUART1("--- MESSAGES ---\r\n");
-
-			for (uint16_t i = 3; i < rx_token.total_words; i++) {
-				uint32_t raw = rx_token.data[i];
-				if (raw == POCSAG_IDLE_WORD) continue;
-
-				bool fixed = false;
-				uint32_t clean = try_fix_word(raw, &fixed);
-				if (calculate_syndrom(clean) != 0 || !check_parity(clean)) continue;
-
-				if ((clean & 0x80000000) == 0) {
-					// Výpočet úplné RIC adresy (Adresa + Frame Index)
-					uint8_t wordInBatchPos = i % 16;
-					uint8_t frameIndex = wordInBatchPos / 2;
-					uint32_t addrPart = (clean >> 13) & 0x3FFFF;
-					uint32_t fullRIC = (addrPart << 3) | (frameIndex & 0x07);
-					uint8_t func = (clean >> 11) & 0x03;
-
-					sprintf(buf, "ADR=%07lu FCE=%d ", (unsigned long)fullRIC, func);
-					sendStringUART1(buf);
-
-					textMsg[0] = '\0';
-					bitBuffer = 0;
-					bitsInBuffer = 0;
-				}
-				else {
-					decode_ascii_part(clean, textMsg);
-				}
-			}
-		}
+    //--- Vsechny zpravy tokenu
+    POCSAG_dec_end(&rx_dec);
+    for (uint8_t m = 0; m < rx_dec.count; m++) {
+        sprintf(buf, "ADR=%07lu FCE=%u%s MSG=", (unsigned long)rx_msgs[m].ric, rx_msgs[m].func,
+                rx_msgs[m].errors ? " ERR" : "");
+        sendStringUART1(buf);
+        sendStringUART1(&rx_msg_text[rx_msgs[m].offset]);
+        sendStringUART1("\r\n");
     }
-
-    if (textMsg[0] != '\0') {
-        sendStringUART1("MSG=");
-        sendStringUART1(textMsg);
+    if (rx_dec.overflow) {
+        sendStringUART1("--- MSG OVERFLOW ---\r\n");
     }
 
     sendStringUART1("\r\n");
-//    sendStringUART1("------------------------------------------\r\n");
-//	sprintf(buf, "KALIBRACE: %lu = %0.2f Hz \r\n",calib_count_per_bit,(float)(72000000UL/calib_count_per_bit));
-//	sprintf(buf, "KALIBRACE: %lu\r\n",calib_count_per_bit);
-//	sendStringUART1(buf);
-/*
-	sprintf(buf, "KALIBRACE: %lu  1-bit: %lu ", calib_stop_counter-calib_start_counter, (calib_stop_counter-calib_start_counter)/calib_bits);
-	sendStringUART1(buf);
-	sprintf(buf, " pocet bitu: %u ", calib_bits);
-	sendStringUART1(buf);
-
-	sprintf(buf, "  start: %lu  stop: %lu\r\n", calib_start_counter, calib_stop_counter);
-	sendStringUART1(buf);
-
-	sprintf(buf, "calib_counter: %lu\r\n",(calib_stop_counter-calib_start_counter)/calib_bits);
-	sendStringUART1(buf);
-*/
 	sendStringUART1("--- END ---\r\n");
-    rx_token.ready = false;
+
+    HOST_SendToken(&rx_token, rx_hdr_ok);  //-- kazdy token i binarne (param.host_port)
 
     //-------------- Kontrola a vysilani
-    if (rx_token.rx_ok)   //-- jen kompletne prijate tokeny
+    if (rx_token.rx_ok && rx_hdr_ok)   //-- jen kompletne prijate tokeny
 //    if (rx_token.rx_ok && rx_token.net==15 && rx_token.adr==3)   //-- jen kompletne prijate tokeny pro mne
     {
         if (rx_token.adr == param.netdau[rx_token.net-1])   //-- je pro mne
@@ -784,28 +1398,40 @@ void POCSAG_process(void) {
         	//-- zjisti komu vysilat
         	make_route(rx_token.net, rx_token.path, rx_token.dau);
 
-        	//-- Vysilam
-			tx_token = rx_token;
-			tx_token.adr = route.follow;
-			tx_token.dau = param.netdau[rx_token.net-1];
-			make_header(&tx_token);  //-- Vygeneruje binární podobu hlavičky
-
-			//-- Nastavi cekani na potvrzeni tokenu
-			route_state = WAIT_FOLLOW;
-			route_repeat_counter = param.next_rpt+1;
-			route_timer = param.next_time+1;
-			LED4_On();
-
-			tx_start();  //-- Spusti vysilani
+        	//-- Vysilam - token se pripravi primo ve fronte
+			POCSAG_token *t = tx_queue_slot(rx_token.system_token ? POCSAG_TXQ_SYSTEM : POCSAG_TXQ_NORMAL);
+			if (t == NULL) {
+				sendStringUART1("TXQ: fronta plna, token zahozen\r\n");
+			}
+			else {
+				*t = rx_token;
+				t->adr = route.follow;
+				t->dau = param.netdau[rx_token.net-1];
+				make_header(t);  //-- Vygeneruje binární podobu hlavičky
+
+				//-- Nastavi cekani na potvrzeni tokenu
+				if (route_state != STATE_ROUTE_IDLE) {
+					sendStringUART1("ROUTE: predchozi token nepotvrzen\r\n");
+					tx_queue_purge(POCSAG_TXQ_RETRY);
+				}
+				route_token = *t;
+				route_retried = false;
+				route_state = WAIT_FOLLOW;
+				route_repeat_counter = param.next_rpt+1;
+				route_timer = param.next_time+1;
+				LED4_On();
+			}
 
         }
         else {  //-- token neni pro mne, kontrola routingu
     		sendStringUART1("NEVYSILAM\r\n");
 
     		if (route_state == WAIT_FOLLOW || route_state == WAIT_ERROR) {
-        		if (rx_token.net == tx_token.net && rx_token.dau == tx_token.adr) {
+        		if (rx_token.net == route_token.net && rx_token.dau == route_token.adr) {
         			//-- je to ten co cekam
+        			if (!route_retried) preamble_locked(route_token.adr);
         			route_state = STATE_ROUTE_IDLE;
+        			tx_queue_purge(POCSAG_TXQ_RETRY);
         			LED4_Off();
         			sendStringUART1("Token potvrzen\r\n");
         		}
@@ -827,22 +1453,24 @@ void routing_handler(void) {
 			case WAIT_FOLLOW:
 				route_timer--;
 				if (route_timer==0) {
+					if (!route_retried) preamble_missed(route_token.adr);
+					route_retried = true;
 					route_repeat_counter--;
 					if (route_repeat_counter==0) {
 						//-- Konec opakovani primou cestou, opakuje chybovou
 						route_state = WAIT_ERROR;
-						tx_token.adr = route.error;
+						route_token.adr = route.error;
 						route_repeat_counter = param.error_rpt+1;
 						route_timer = param.next_time+1;
-						make_header(&tx_token);  //-- Vygeneruje binární podobu hlavičky
+						make_header(&route_token);  //-- Vygeneruje binární podobu hlavičky
 						sendStringUART1("ERROR-PATH\r\n");
-						tx_start();
+						POCSAG_tx_queue(&route_token, POCSAG_TXQ_RETRY);
 					}
 					else {
 						//-- opakuje primou cestou
 						route_timer = param.next_time+1;
 						sendStringUART1("REPEAT\r\n");
-						tx_start();
+						POCSAG_tx_queue(&route_token, POCSAG_TXQ_RETRY);
 					}
 				}
 				break;
@@ -854,18 +1482,18 @@ void routing_handler(void) {
 					if (route_repeat_counter==0) {
 						//-- Konec opakovani chybovou cestou, posle REVERSAL
 						route_state = STATE_ROUTE_IDLE;  //-- nebude cekat
-						tx_token.adr = route.revers;
+						route_token.adr = route.revers;
 						route_repeat_counter = 0;
 						route_timer = 0;
-						make_header(&tx_token);  //-- Vygeneruje binární podobu hlavičky
+						make_header(&route_token);  //-- Vygeneruje binární podobu hlavičky
 						sendStringUART1("REVERSAL\r\n");
-						tx_start();
+						POCSAG_tx_queue(&route_token, POCSAG_TXQ_RETRY);
 					}
 					else {
 						//-- opakuje chybovou cestou
 						route_timer = param.next_time+1;
 						sendStringUART1("REPEAT ERROR\r\n");
-						tx_start();
+						POCSAG_tx_queue(&route_token, POCSAG_TXQ_RETRY);
 					}
 				}
 				break;
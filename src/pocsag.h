@@ -7,12 +7,55 @@
 #define MAX_BATCHES      10
 #define WORDS_PER_BATCH  16
 #define POCSAG_SYNC_WORD 0x7CD215D8  // FS t.j. synchronizacni slovo
+#define POCSAG_PREAMBLE_MAX   576   // bitu, standardni delka preamble
+#define POCSAG_PREAMBLE_MIN   128   // bitu, kratsi uz nestaci na detekci rychlosti
+#define POCSAG_PREAMBLE_STEP  32    // zkraceni pri adaptaci
+#define POCSAG_PREAMBLE_LOCKS 4     // potvrzeni na prvni pokus v rade pred zkracenim
+#if (POCSAG_PREAMBLE_MAX % 32) || (POCSAG_PREAMBLE_MIN % 32) || (POCSAG_PREAMBLE_STEP % 32)
+#error "Preamble se vysila po celych 32bitovych slovech (tx_serialize)"
+#endif
+#define POCSAG_SYNC_ERR_MAX 4        // max. chyb v FS (od preamble se FS lisi min. v 9 bitech)
 #define POCSAG_IDLE_WORD 0x7A89C197
 
+//--- Rezim prijmu
+//    0     = 1 vzorek na bit, faze se nastavuje hranou (POCSAG_edge_detected)
+//    8, 16 = N vzorku na bit, bit = vetsina ze stredni poloviny vzorku,
+//            faze bitu se doladuje PI smyckou (DPLL) z hran ve vzorcich.
+//    Rozpocet CPU: obsluha vzorku v TIMER1 max. 300 taktu, tj. pri 16x
+//    max. 4800 taktu na bit = 8% z 60000 taktu bitove periody.
+#define POCSAG_RX_OVERSAMPLE  0
+
+//--- Vysilani
+//    0 = bity vysila TIMER1_IRQHandler na TX_PIN (GPIO)
+//    1 = pripraveny proud vysila USART1 v synchronnim rezimu, plni ho LDMA,
+//        CPU se ozve az na konci tokenu (txsync.c). 512 bps jde vzdy pres GPIO.
+#define POCSAG_TX_USART  0
+
+//--- Stav prijateho slova v POCSAG_token.status[]
+//    bity 1..0 = stav, bity 3..2 = pocet opravenych bitu
+#define WORD_OK            0x00   // bez chyby
+#define WORD_FIXED         0x01   // opraveno (1 nebo 2 bity)
+#define WORD_ERROR         0x02   // neopravitelne
+#define WORD_STATE(s)      ((s) & 0x03)
+#define WORD_FIXED_BITS(s) (((s) >> 2) & 0x03)
+
 typedef struct {
     uint32_t data[MAX_BATCHES * WORDS_PER_BATCH];
+    uint8_t  status[MAX_BATCHES * WORDS_PER_BATCH];  // WORD_xxx, plni POCSAG_validate()
     uint16_t total_words;
-    volatile bool ready;    // Dokoncen prijem tokenu
+    uint32_t dirty[(MAX_BATCHES * WORDS_PER_BATCH + 31) / 32];  // slova ke prepocitani BCH (make_bch)
+    uint16_t fixed_words;   // Pocet opravenych slov
+    uint16_t error_words;   // Pocet neopravitelnych slov
+    uint8_t  sync_dist;     // Nejvetsi Hammingova vzdalenost prijatych FS
+    uint8_t  inverted;      // 1 = token prijat s obracenou polaritou
+    uint16_t bps;           // Nominalni rychlost tokenu (512/1200/2400)
+    uint32_t period_start;  // Perioda bitu po kalibraci z preamble (tiky 72MHz)
+    uint32_t period_end;    // Perioda bitu na konci tokenu (po sledovani)
+    uint32_t rate_mHz;      // Odhad bitove rychlosti na konci tokenu v mHz
+    int32_t  drift_ppm;     // Zmena rychlosti behem tokenu, + = vysilac zrychlil
+    uint32_t fs_ticks;      // WTIMER0 (72MHz, volne bezici) pri prvnim FS
+    uint32_t uptime_s;      // Vteriny od startu pri zacatku tokenu
+    bool ready;             // Dokoncen prijem tokenu (nastavi POCSAG_process)
     bool rx_ok;             // Token prijat bezchybne nebo chyby opraveny
     //------------------------------ Hlavicka prijateho POCSAG tokenu.
 	unsigned char batch;	// Pocet batch - udaj uvedeny v hlavicce tokenu (nikoliv prijatych)
@@ -27,13 +70,30 @@ typedef struct {
 
 //extern POCSAG_token rx_token;
 
+//--- Oznaceni zmeneneho slova - make_bch() prepocita jen oznacena slova
+#define POCSAG_MARK_DIRTY(t, i)  ((t)->dirty[(i) / 32] |= 1UL << ((i) % 32))
+
+//--- Priority fronty vysilani (mensi = drive)
+#define POCSAG_TXQ_SYSTEM  0   // systemovy token
+#define POCSAG_TXQ_RETRY   1   // opakovani, chybova a reverzni cesta
+#define POCSAG_TXQ_NORMAL  2   // novy token
+#define POCSAG_TXQ_PRIOS   3
+
 void POCSAG_rx_init(void);
-void POCSAG_edge_detected(void); // volano interuptem GPIO_EVEN_IRQHandler()
+void POCSAG_edge_detected(uint32_t timestamp); // volano z Input_ProcessEdges()
+void POCSAG_edge_track(uint32_t timestamp);    // -"- pri vypnute synchronizaci hranou
 void POCSAG_sample_bit(void);    // volano z TIMER1 (1200 Hz)
 void POCSAG_process(void);       // volano v main loop
+void POCSAG_validate(POCSAG_token *token);
+void POCSAG_validate_word(POCSAG_token *token, uint16_t i);
 //void POCSAG_Tx_datagram(void);
 void POCSAG_show_rx_state(void);
 void tx_start(void);
+bool POCSAG_tx_queue(const POCSAG_token *token, uint8_t prio);
+bool POCSAG_tx_repeat(void);            // posledni vysilany token znovu do fronty
+bool POCSAG_tx_inject(POCSAG_token *token, uint8_t prio);  // cizi token: hlavicka + BCH vsech slov
+void POCSAG_tx_done(void);       // konec vysilani pres USART (txsync.c)
+void POCSAG_ptt_timer(void);     // uplynul PTT predstih / dobeh (TIMER2_IRQHandler)
 void routing_handler(void);
 
 #endif
@@ -0,0 +1,141 @@
+/******************************************************************************
+ * @file pocsag_msg.c
+ * @brief Dekoder zprav POCSAG - adresy, alfanumericke a numericke zpravy
+ *
+ * Slova tokenu se predavaji postupne, jak prichazeji. Adresni CW zahajuje
+ * novou zpravu, zpravove CW pridavaji 20 bitu textu, IDLE nebo dalsi adresa
+ * zpravu ukonci. Znaky se posilaji LSB napred: alfanumericke po 7 bitech
+ * (ASCII), numericke po 4 bitech (BCD). Znak muze prechazet pres hranici slov.
+ *
+ * Texty vsech zprav se skladaji za sebe do bufferu volajiciho, kazdy je
+ * ukoncen '\0'. Delka se vede v kontextu, buffer se nikdy neprochazi.
+ *****************************************************************************/
+#include "pocsag_msg.h"
+#include "pocsag.h"
+
+//--- Znaky numericke zpravy (BCD 0..F)
+static const char numeric_chars[16] = {
+    '0','1','2','3','4','5','6','7','8','9','*','U',' ','-',')','('
+};
+
+//------------------------------------------------------------------------------
+// Inicializace kontextu nad buffery volajiciho
+//------------------------------------------------------------------------------
+void POCSAG_dec_init(POCSAG_decoder *d, char *buf, uint16_t size, POCSAG_msg *msgs, uint8_t max_msgs) {
+    d->buf = buf;
+    d->size = size;
+    d->used = 0;
+    d->msgs = msgs;
+    d->max_msgs = max_msgs;
+    d->count = 0;
+    d->open = false;
+    d->overflow = false;
+    d->bits = 0;
+    d->nbits = 0;
+    d->erased = false;
+    if (size > 0) buf[0] = '\0';
+}
+
+//------------------------------------------------------------------------------
+// Uzavre rozpracovanou zpravu - nedokonceny znak se zahodi
+//------------------------------------------------------------------------------
+static void msg_close(POCSAG_decoder *d) {
+    if (!d->open) return;
+    d->buf[d->used++] = '\0';  // misto pro '\0' je rezervovane v msg_put()
+    d->open = false;
+}
+
+//------------------------------------------------------------------------------
+// Prida znak do otevrene zpravy, posledni bajt bufferu zustava pro '\0'
+//------------------------------------------------------------------------------
+static void msg_put(POCSAG_decoder *d, char c) {
+    if (d->used + 1 >= d->size) {
+        d->overflow = true;
+        return;
+    }
+    d->buf[d->used++] = c;
+    d->msgs[d->count - 1].len++;
+}
+
+//------------------------------------------------------------------------------
+// Adresni CW - zahaji novou zpravu
+//------------------------------------------------------------------------------
+static void msg_open(POCSAG_decoder *d, uint32_t word, uint8_t frame) {
+    msg_close(d);
+    d->bits = 0;
+    d->nbits = 0;
+    d->erased = false;
+
+    if (d->count >= d->max_msgs || d->used >= d->size) {
+        d->overflow = true;
+        return;
+    }
+
+    POCSAG_msg *m = &d->msgs[d->count++];
+    m->ric = (((word >> 13) & 0x3FFFF) << 3) | (frame & 0x07);
+    m->func = (uint8_t)((word >> 11) & 0x03);
+    m->errors = 0;
+    m->offset = d->used;
+    m->len = 0;
+    d->open = true;
+}
+
+//------------------------------------------------------------------------------
+// 20 bitu zpravoveho CW do rozpracovanych znaku (bity 30..11, prvni = LSB znaku)
+// erased = bity z neopravitelneho slova, dotcene znaky se nahradi '?'
+//------------------------------------------------------------------------------
+static void msg_data(POCSAG_decoder *d, uint32_t word, bool erased) {
+    POCSAG_msg *m = &d->msgs[d->count - 1];
+    uint8_t width = (m->func == POCSAG_FUNC_NUMERIC) ? 4 : 7;
+
+    for (int8_t i = 30; i >= 11; i--) {
+        d->bits |= (uint8_t)(((word >> i) & 1) << d->nbits);
+        d->erased |= erased;
+        if (++d->nbits < width) continue;
+
+        if (d->erased) {
+            msg_put(d, '?');
+        }
+        else if (width == 4) {
+            msg_put(d, numeric_chars[d->bits]);
+        }
+        else if (d->bits >= 32 && d->bits <= 126) {
+            msg_put(d, (char)d->bits);
+        }
+        d->bits = 0;
+        d->nbits = 0;
+        d->erased = false;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Jedno slovo tokenu (uz opravene), ok = slovo neni WORD_ERROR
+//------------------------------------------------------------------------------
+void POCSAG_dec_word(POCSAG_decoder *d, uint32_t word, uint8_t frame, bool ok) {
+    if (!ok) {
+        //-- Nevime, jestli to byla adresa nebo text - bity se vynechaji,
+        //   zarovnani znaku zustane zachovane
+        if (d->open) {
+            d->msgs[d->count - 1].errors++;
+            msg_data(d, 0, true);
+        }
+        return;
+    }
+
+    if (word == POCSAG_IDLE_WORD) {
+        msg_close(d);
+    }
+    else if ((word & 0x80000000) == 0) {
+        msg_open(d, word, frame);
+    }
+    else if (d->open) {
+        msg_data(d, word, false);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Konec tokenu
+//------------------------------------------------------------------------------
+void POCSAG_dec_end(POCSAG_decoder *d) {
+    msg_close(d);
+}
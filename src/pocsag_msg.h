@@ -0,0 +1,41 @@
+/******************************************************************************
+ * @file pocsag_msg.h
+ * @brief Dekoder zprav POCSAG - adresy, alfanumericke a numericke zpravy
+ *****************************************************************************/
+#ifndef POCSAG_MSG_H
+#define POCSAG_MSG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define POCSAG_FUNC_NUMERIC  0   // funkcni kod numericke (BCD) zpravy, ostatni = 7-bit ASCII
+
+//--- Jedna zprava: adresa + text v bufferu volajiciho
+typedef struct {
+    uint32_t ric;       // uplna adresa (adresa z CW + cislo ramce)
+    uint8_t  func;      // funkcni kod 0..3
+    uint8_t  errors;    // pocet neopravitelnych slov ve zprave (znaky nahrazeny '?')
+    uint16_t offset;    // zacatek textu v buf[], text je ukoncen '\0'
+    uint16_t len;       // delka textu bez '\0'
+} POCSAG_msg;
+
+//--- Kontext dekoderu - vsechen stav je tady, funkce jsou reentrantni
+typedef struct {
+    char       *buf;        // buffer volajiciho pro texty vsech zprav
+    uint16_t    size;       // velikost buf[]
+    uint16_t    used;       // obsazeno vcetne ukoncovacich '\0'
+    POCSAG_msg *msgs;       // pole zprav volajiciho
+    uint8_t     max_msgs;
+    uint8_t     count;      // pocet zprav (i rozpracovane)
+    bool        open;       // posledni zprava jeste pokracuje
+    bool        overflow;   // nevesel se text nebo zprava
+    uint8_t     bits;       // rozpracovany znak
+    uint8_t     nbits;      // pocet bitu v rozpracovanem znaku
+    bool        erased;     // rozpracovany znak obsahuje bity z chybneho slova
+} POCSAG_decoder;
+
+void POCSAG_dec_init(POCSAG_decoder *d, char *buf, uint16_t size, POCSAG_msg *msgs, uint8_t max_msgs);
+void POCSAG_dec_word(POCSAG_decoder *d, uint32_t word, uint8_t frame, bool ok);  // frame = pozice v batch / 2
+void POCSAG_dec_end(POCSAG_decoder *d);  // konec tokenu, uzavre posledni zpravu
+
+#endif /* POCSAG_MSG_H */
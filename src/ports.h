@@ -47,6 +47,50 @@
 #define LED_TX_PORT         (gpioPortD)
 #define LED_TX_PIN          (3)
 
+/* --- Seriove porty (serial.c), 8N1 --- */
+#define COM_A_TX_PORT       (gpioPortC)         /* UART0 LOCATION 4 */
+#define COM_A_TX_PIN        (4)
+#define COM_A_RX_PORT       (gpioPortC)
+#define COM_A_RX_PIN        (5)
+#define COM_A_LOC           (4)
+#define COM_A_BAUD          (9600)
+
+#define COM_B_TX_PORT       (gpioPortE)         /* UART1 LOCATION 4 */
+#define COM_B_TX_PIN        (12)
+#define COM_B_RX_PORT       (gpioPortE)
+#define COM_B_RX_PIN        (13)
+#define COM_B_LOC           (4)
+#define COM_B_BAUD          (115200)
+
+#define COM_C_TX_PORT       (gpioPortE)         /* USART0 LOCATION 0 */
+#define COM_C_TX_PIN        (10)
+#define COM_C_RX_PORT       (gpioPortE)
+#define COM_C_RX_PIN        (11)
+#define COM_C_LOC           (0)
+#define COM_C_BAUD          (115200)
+
+/* --- PRS a LDMA kanaly --- */
+#define EDGE_PRS_CH         (0)                 /* PA0 -> WTIMER0 CC0 */
+#define EDGE_TIMER_PRSSEL   (timerPRSSELCh0)
+#define LDMA_CH_EDGE        (0)                 /* WTIMER0 CC0 -> edge_ring[] */
+#define LDMA_CH_TXSYNC      (1)                 /* tx_stream[] -> USART1 TXDATA */
+#define LDMA_CH_UART0_TX    (2)                 /* uart0_tx -> UART0 TXDATA */
+#define LDMA_CH_UART1_TX    (3)                 /* uart1_tx -> UART1 TXDATA */
+#define LDMA_CH_USART0_TX   (4)                 /* usart0_tx -> USART0 TXDATA */
+#define LDMA_CH_UART0_RX    (5)                 /* UART0 RXDATA -> uart0_rx, dokola */
+#define LDMA_CH_UART1_RX    (6)                 /* UART1 RXDATA -> uart1_rx, dokola */
+#define LDMA_CH_USART0_RX   (7)                 /* USART0 RXDATA -> usart0_rx, dokola */
+
+/* --- Vysilani POCSAG pres USART (POCSAG_TX_USART) --- */
+/* Vystup USART1 TX musi byt propojen na vstup vysilacky misto PA1 (TX_PIN) */
+#define TXSYNC_USART        (USART1)
+#define TXSYNC_CLOCK        (cmuClock_USART1)
+#define TXSYNC_TX_IRQn      (USART1_TX_IRQn)
+#define TXSYNC_LDMA_SIGNAL  (ldmaPeripheralSignal_USART1_TXBL)
+#define TXSYNC_TXLOC        (0)
+#define TXSYNC_TX_PORT      (gpioPortC)         /* US1_TX LOC0 = PC0 */
+#define TXSYNC_TX_PIN       (0)
+
 /* --- Frekvencni konstanty --- */
 #define HFXO_FREQ           50000000UL
 #define HFCLK_FREQ          72000000UL
@@ -54,4 +98,15 @@
 /* --- Velikost bufferu --- */
 #define BUFFER_SIZE         256
 
+/* --- Buffery vysilani UART (mocnina 2) - UART1 pojme cely vypis tokenu --- */
+#define UART_TX_DMA         1   /* 1 = buffery odesila LDMA (ping-pong), 0 = preruseni TXBL */
+#define UART0_TX_SIZE       1024
+#define UART1_TX_SIZE       8192
+#define USART0_TX_SIZE      1024
+
+/* --- Buffery prijmu UART (mocnina 2, max. 2048) - plni LDMA dokola --- */
+#define UART0_RX_SIZE       1024
+#define UART1_RX_SIZE       2048                /* 921600 Bd = 22 ms */
+#define USART0_RX_SIZE      2048
+
 #endif /* PORTS_H */
@@ -0,0 +1,120 @@
+/******************************************************************************
+ * @file rxbuf.c
+ * @brief Kruhovy buffer prijmu UART/USART plneny LDMA, konec davky = RX timeout
+ *
+ * Puvodne vyvolal kazdy prijaty bajt preruseni a radek se skladal v ISR.
+ * Ted bajty odnasi LDMA do kruhoveho bufferu (deskriptor odkazuje sam na
+ * sebe, stejne jako edge_ring v inputs.c) a preruseni jsou jen dve:
+ *   - TCMP1 portu: RX timeout, linka je RXBUF_TIMEOUT_BAUDS bitu v klidu,
+ *     davka je kompletni -> hlavni smycka ji zpracuje najednou
+ *   - LDMA DONE: jeden obeh bufferu, z poctu obehu se pozna prepsani dat
+ *
+ * Pri souvislem proudu bez mezer hlavni smycka cte uz od poloviny bufferu.
+ *****************************************************************************/
+#include "rxbuf.h"
+#include "em_device.h"
+#include <stddef.h>
+
+static rxbuf *rxbuf_dma[DMA_CHAN_COUNT];   // buffery podle kanalu LDMA
+
+uint16_t RXBUF_Size(const rxbuf *b) {
+    return (uint16_t)(b->mask + 1);
+}
+
+//------------------------------------------------------------------------------
+// Pozice zapisu LDMA v bufferu
+//------------------------------------------------------------------------------
+static uint16_t rxbuf_head(const rxbuf *b) {
+    return (uint16_t)((LDMA->CH[b->dma_ch].DST - (uint32_t)b->buf) & b->mask);
+}
+
+//------------------------------------------------------------------------------
+// Spusti kruhovy prijem: RXDATAV -> LDMA -> buf[], RX timeout na TIMECMP1
+//------------------------------------------------------------------------------
+void RXBUF_Init(rxbuf *b, uint8_t ch, uint32_t signal) {
+    b->dma_ch = ch;
+    b->tail = 0;
+    b->consumed = 0;
+    b->wraps = 0;
+    b->idle = false;
+    rxbuf_dma[ch] = b;
+
+    b->dma_desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&b->usart->RXDATA, b->buf, b->mask + 1, 0);
+    LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(signal);
+    LDMA_StartTransfer(ch, &cfg, &b->dma_desc);   // DONE po kazdem obehu
+
+    //-- Citac spusti konec znaku, zastavi dalsi start bit
+    b->usart->TIMECMP1 = USART_TIMECMP1_TSTART_RXEOF | USART_TIMECMP1_TSTOP_RXACT
+                       | USART_TIMECMP1_RESTARTEN
+                       | ((uint32_t)RXBUF_TIMEOUT_BAUDS << _USART_TIMECMP1_TCMPVAL_SHIFT);
+    USART_IntClear(b->usart, USART_IFC_TCMP1);
+    USART_IntEnable(b->usart, USART_IEN_TCMP1);
+}
+
+//------------------------------------------------------------------------------
+// Je co zpracovat - davka skoncila, nebo se buffer plni souvislym proudem
+//------------------------------------------------------------------------------
+bool RXBUF_Ready(rxbuf *b) {
+    uint16_t used = (uint16_t)((rxbuf_head(b) - b->tail) & b->mask);
+    return (used != 0) && (b->idle || used >= (b->mask + 1) / 2);
+}
+
+//------------------------------------------------------------------------------
+// Precte az max bajtu. Pokud LDMA mezitim obehlo cely buffer, nejstarsi data
+// jsou prepsana - preskoci se a zapocitaji do overruns.
+// Konec davky (idle) plati, dokud neni precteno vse - davka delsi nez max se
+// tak docte dalsimi volanimi hned, ne az po RX timeoutu dalsi davky.
+//------------------------------------------------------------------------------
+uint16_t RXBUF_Read(rxbuf *b, char *out, uint16_t max) {
+    uint16_t head  = rxbuf_head(b);
+    uint32_t total = b->wraps * (uint32_t)(b->mask + 1) + head;
+    int32_t  ahead = (int32_t)(total - b->consumed);
+
+    if (ahead > (int32_t)b->mask) {
+        //-- Obehnuto, plati jen poslednich (velikost - 1) bajtu
+        b->overruns += (uint32_t)ahead - b->mask;
+        b->tail = (uint16_t)((head + 1) & b->mask);
+        b->consumed = total - b->mask;
+    }
+
+    uint16_t used = (uint16_t)((head - b->tail) & b->mask);
+    if (used > b->hwm) b->hwm = used;
+    if (used > max) used = max;
+
+    for (uint16_t i = 0; i < used; i++) {
+        out[i] = b->buf[b->tail];
+        b->tail = (uint16_t)((b->tail + 1) & b->mask);
+    }
+    b->consumed += used;
+
+    //-- Timeout prijde az RXBUF_TIMEOUT_BAUDS po poslednim bajtu, ten uz je
+    //   v tu chvili v bufferu -> pri prazdnem bufferu se nova davka neztrati
+    if (b->tail == rxbuf_head(b)) b->idle = false;
+    return used;
+}
+
+//------------------------------------------------------------------------------
+// RX timeout - linka utichla
+//------------------------------------------------------------------------------
+void RXBUF_IRQHandler(rxbuf *b) {
+    uint32_t flags = USART_IntGet(b->usart);
+    USART_IntClear(b->usart, flags);
+
+    if (flags & USART_IF_TCMP1) {
+        b->idle = true;
+        b->bursts++;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Obeh LDMA pres buffer
+//------------------------------------------------------------------------------
+void RXBUF_LdmaIrq(uint32_t pending) {
+    for (uint8_t ch = 0; ch < DMA_CHAN_COUNT; ch++) {
+        rxbuf *b = rxbuf_dma[ch];
+        if (b == NULL || (pending & (1UL << ch)) == 0) continue;
+
+        LDMA_IntClear(1UL << ch);
+        b->wraps++;
+    }
+}
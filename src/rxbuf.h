@@ -0,0 +1,41 @@
+/******************************************************************************
+ * @file rxbuf.h
+ * @brief Kruhovy buffer prijmu UART/USART plneny LDMA, konec davky = RX timeout
+ *****************************************************************************/
+#ifndef RXBUF_H
+#define RXBUF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_usart.h"   /* USART_TypeDef */
+#include "em_ldma.h"
+
+#define RXBUF_TIMEOUT_BAUDS  32   // ticho na lince (bitove periody) = konec davky
+
+//--- Buffer jednoho portu. Plni ho LDMA dokola, cte jen hlavni smycka.
+typedef struct {
+    USART_TypeDef    *usart;
+    char             *buf;
+    uint16_t          mask;      // velikost - 1, velikost je mocnina 2 (max. 2048)
+    uint8_t           dma_ch;
+    uint16_t          tail;      // dalsi neprecteny bajt
+    uint32_t          consumed;  // celkem prectenych (a preskocenych) bajtu
+    volatile uint32_t wraps;     // obehy LDMA pres cely buffer
+    volatile uint32_t bursts;    // davky ukoncene RX timeoutem
+    volatile bool     idle;      // linka utichla, davka je kompletni
+    uint16_t          hwm;       // nejvyssi zaplneni (high-water mark)
+    uint32_t          overruns;  // bajty prepsane drive, nez je hlavni smycka precetla
+    uint32_t          line_drops;// bajty za koncem radku (BUFFER_SIZE), pocita vlastnik
+    LDMA_Descriptor_t dma_desc;
+} rxbuf;
+
+#define RXBUF_INIT(u, mem)  { .usart = (u), .buf = (mem), .mask = sizeof(mem) - 1 }
+
+void     RXBUF_Init(rxbuf *b, uint8_t ch, uint32_t signal);  // po nastaveni portu, LDMA uz bezi
+bool     RXBUF_Ready(rxbuf *b);                    // konec davky nebo buffer z poloviny plny
+uint16_t RXBUF_Read(rxbuf *b, char *out, uint16_t max);
+uint16_t RXBUF_Size(const rxbuf *b);
+void     RXBUF_IRQHandler(rxbuf *b);               // z UARTx_RX_IRQHandler (TCMP1)
+void     RXBUF_LdmaIrq(uint32_t pending);          // z LDMA_IRQHandler
+
+#endif /* RXBUF_H */
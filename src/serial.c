@@ -0,0 +1,294 @@
+/******************************************************************************
+ * @file serial.c
+ * @brief Spolecny ovladac seriovych portu COM-A/B/C - tabulka popisu portu
+ *
+ * Nahrazuje tri kopie uart0.c, uart1.c a usart0.c. Vsechny porty jsou 8N1
+ * (prevzorkovani 16/8/6/4 podle rychlosti, serial_set_baud) a lisi se jen
+ * polozkami v serial_ports[]: periferie, piny, LOCATION, rychlost, kanaly
+ * LDMA a obsluha prijatych znaku a radku.
+ *
+ * Vysilani: txbuf.c (LDMA ping-pong nebo TXBL preruseni, UART_TX_DMA)
+ * Prijem:   rxbuf.c (LDMA dokola + RX timeout), radky sklada Serial_Poll()
+ *****************************************************************************/
+#include <stdio.h>
+#include "serial.h"
+
+static char com_a_tx[UART0_TX_SIZE],  com_a_rx[UART0_RX_SIZE];
+static char com_b_tx[UART1_TX_SIZE],  com_b_rx[UART1_RX_SIZE];
+static char com_c_tx[USART0_TX_SIZE], com_c_rx[USART0_RX_SIZE];
+
+static void echo_line(uint8_t com, char *line, uint16_t len);
+
+serial_port serial_ports[SERIAL_PORTS] = {
+    [SERIAL_COM_A] = {
+        .name = "UART0 ", .usart = UART0, .clock = cmuClock_UART0,
+        .tx_port = COM_A_TX_PORT, .tx_pin = COM_A_TX_PIN,
+        .rx_port = COM_A_RX_PORT, .rx_pin = COM_A_RX_PIN,
+        .location = COM_A_LOC, .baud = COM_A_BAUD,
+        .rx_irq = UART0_RX_IRQn, .tx_irq = UART0_TX_IRQn,
+        .tx_dma_ch = LDMA_CH_UART0_TX, .tx_dma_signal = ldmaPeripheralSignal_UART0_TXBL,
+        .rx_dma_ch = LDMA_CH_UART0_RX, .rx_dma_signal = ldmaPeripheralSignal_UART0_RXDATAV,
+        .on_line = echo_line,
+        .tx = TXBUF_INIT(UART0, com_a_tx), .rx = RXBUF_INIT(UART0, com_a_rx),
+    },
+    [SERIAL_COM_B] = {
+        .name = "UART1 ", .usart = UART1, .clock = cmuClock_UART1,
+        .tx_port = COM_B_TX_PORT, .tx_pin = COM_B_TX_PIN,
+        .rx_port = COM_B_RX_PORT, .rx_pin = COM_B_RX_PIN,
+        .location = COM_B_LOC, .baud = COM_B_BAUD,
+        .rx_irq = UART1_RX_IRQn, .tx_irq = UART1_TX_IRQn,
+        .tx_dma_ch = LDMA_CH_UART1_TX, .tx_dma_signal = ldmaPeripheralSignal_UART1_TXBL,
+        .rx_dma_ch = LDMA_CH_UART1_RX, .rx_dma_signal = ldmaPeripheralSignal_UART1_RXDATAV,
+        .tx = TXBUF_INIT(UART1, com_b_tx), .rx = RXBUF_INIT(UART1, com_b_rx),
+    },
+    [SERIAL_COM_C] = {
+        .name = "USART0", .usart = USART0, .clock = cmuClock_USART0,
+        .tx_port = COM_C_TX_PORT, .tx_pin = COM_C_TX_PIN,
+        .rx_port = COM_C_RX_PORT, .rx_pin = COM_C_RX_PIN,
+        .location = COM_C_LOC, .baud = COM_C_BAUD,
+        .rx_irq = USART0_RX_IRQn, .tx_irq = USART0_TX_IRQn,
+        .tx_dma_ch = LDMA_CH_USART0_TX, .tx_dma_signal = ldmaPeripheralSignal_USART0_TXBL,
+        .rx_dma_ch = LDMA_CH_USART0_RX, .rx_dma_signal = ldmaPeripheralSignal_USART0_RXDATAV,
+        .on_line = echo_line,
+        .tx = TXBUF_INIT(USART0, com_c_tx), .rx = RXBUF_INIT(USART0, com_c_rx),
+    },
+};
+
+//------------------------------------------------------------------------------
+// Vychozi obsluha radku COM-A a COM-C - posle radek zpet
+//------------------------------------------------------------------------------
+static void echo_line(uint8_t com, char *line, uint16_t len)
+{
+    Serial_Puts(com, line);
+    Serial_Puts(com, "\r\n");
+}
+
+//------------------------------------------------------------------------------
+// Rychlost portu: baud = f / (OVS * (1 + DIV/256)), DIV po 1/32 (bity 22..3).
+// Pro kazde prevzorkovani se DIV zaokrouhli na nejblizsi krok a vybere se
+// nejmensi odchylka, pri shode vyssi prevzorkovani (lepsi odolnost sumu).
+// 72MHz: 9600/115200 OVS16, 460800 OVS8, 921600 OVS4 - vse presne (0 ppm).
+//------------------------------------------------------------------------------
+static const struct {
+    uint8_t  ovs;
+    uint32_t ctrl;
+} serial_ovs[] = {
+    { 16, USART_CTRL_OVS_X16 },
+    {  8, USART_CTRL_OVS_X8  },
+    {  6, USART_CTRL_OVS_X6  },
+    {  4, USART_CTRL_OVS_X4  },
+};
+
+static bool serial_set_baud(serial_port *p, uint32_t baud)
+{
+    uint32_t freq = CMU_ClockFreqGet(p->clock);
+    int8_t   best = -1;
+    uint32_t best_n32 = 0, best_actual = 0, best_abs = 0xFFFFFFFF;
+    int32_t  best_err = 0;
+
+    if (baud == 0) return false;
+
+    for (uint8_t i = 0; i < sizeof(serial_ovs) / sizeof(serial_ovs[0]); i++) {
+        uint64_t ovs = serial_ovs[i].ovs;
+        uint64_t den = ovs * baud;
+        uint64_t n32 = ((uint64_t)freq * 32 + den / 2) / den;   // 32 * (1 + DIV/256)
+        if (n32 < 32 || n32 - 32 > (_USART_CLKDIV_DIV_MASK >> 3)) continue;
+
+        uint32_t actual = (uint32_t)(((uint64_t)freq * 32 + ovs * n32 / 2) / (ovs * n32));
+        int32_t  err = (int32_t)(((int64_t)actual - (int64_t)baud) * 1000000 / (int64_t)baud);
+        uint32_t abs_err = (uint32_t)(err < 0 ? -err : err);
+        if (abs_err < best_abs) {
+            best = (int8_t)i;
+            best_n32 = (uint32_t)n32;
+            best_actual = actual;
+            best_err = err;
+            best_abs = abs_err;
+        }
+    }
+    if (best < 0 || best_abs > SERIAL_BAUD_ERR_MAX_PPM) return false;
+
+    p->usart->CTRL   = (p->usart->CTRL & ~_USART_CTRL_OVS_MASK) | serial_ovs[best].ctrl;
+    p->usart->CLKDIV = (best_n32 - 32) << 3;
+    p->baud = baud;
+    p->baud_actual = best_actual;
+    p->baud_err_ppm = best_err;
+    p->ovs = serial_ovs[best].ovs;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Init jednoho portu - 8N1, OVS a CLKDIV podle rychlosti, prijem a vysilani
+// pres buffery
+//------------------------------------------------------------------------------
+static void serial_init_port(serial_port *p)
+{
+    USART_TypeDef *u = p->usart;
+
+    CMU_ClockEnable(p->clock, true);
+    CMU_ClockEnable(cmuClock_GPIO, true);
+
+    GPIO_PinModeSet(p->tx_port, p->tx_pin, gpioModePushPull, 1);
+    GPIO_PinModeSet(p->rx_port, p->rx_pin, gpioModeInput,    0);
+
+    u->CMD = USART_CMD_RXDIS | USART_CMD_TXDIS | USART_CMD_MASTERDIS
+           | USART_CMD_RXBLOCKDIS | USART_CMD_TXTRIDIS
+           | USART_CMD_CLEARTX | USART_CMD_CLEARRX;
+
+    u->CTRL  = USART_CTRL_OVS_X16;     // serial_set_baud() muze zmenit
+    u->FRAME = USART_FRAME_DATABITS_EIGHT
+             | USART_FRAME_PARITY_NONE
+             | USART_FRAME_STOPBITS_ONE;
+
+    serial_set_baud(p, p->baud);
+
+    u->ROUTEPEN  = USART_ROUTEPEN_RXPEN | USART_ROUTEPEN_TXPEN;
+    u->ROUTELOC0 = ((uint32_t)p->location << _USART_ROUTELOC0_TXLOC_SHIFT)
+                 | ((uint32_t)p->location << _USART_ROUTELOC0_RXLOC_SHIFT);
+
+    u->CMD = USART_CMD_RXEN | USART_CMD_TXEN;
+
+    // Prijem bez preruseni na bajt - LDMA do bufferu, preruseni jen RX timeout
+    USART_IntClear(u, _USART_IF_MASK);
+    RXBUF_Init(&p->rx, p->rx_dma_ch, p->rx_dma_signal);
+    NVIC_ClearPendingIRQ(p->rx_irq);
+    NVIC_EnableIRQ(p->rx_irq);
+
+    // TXBL povoluje az zapis do bufferu
+    NVIC_ClearPendingIRQ(p->tx_irq);
+    NVIC_EnableIRQ(p->tx_irq);
+#if UART_TX_DMA
+    TXBUF_InitDMA(&p->tx, p->tx_dma_ch, p->tx_dma_signal);
+#endif
+    p->line_len = 0;
+}
+
+void initSerial(void)
+{
+    for (uint8_t com = 0; com < SERIAL_PORTS; com++) {
+        serial_init_port(&serial_ports[com]);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Vychozi obsluha z tabulky (COM-A/C echo radku) - po uvolneni portu protokolem
+//------------------------------------------------------------------------------
+void Serial_DefaultHandlers(uint8_t com)
+{
+    serial_ports[com].line_len = 0;
+    Serial_SetHandlers(com, NULL, (com == SERIAL_COM_B) ? NULL : echo_line);
+}
+
+void Serial_SetHandlers(uint8_t com, serial_char_fn on_char, serial_line_fn on_line)
+{
+    serial_ports[com].on_char = on_char;
+    serial_ports[com].on_line = on_line;
+}
+
+uint16_t Serial_Write(uint8_t com, const char *data, uint16_t len)
+{
+    return TXBUF_Write(&serial_ports[com].tx, data, len);
+}
+
+uint16_t Serial_Read(uint8_t com, char *out, uint16_t max)
+{
+    return RXBUF_Read(&serial_ports[com].rx, out, max);
+}
+
+uint16_t Serial_TxFree(uint8_t com)
+{
+    const txbuf *b = &serial_ports[com].tx;
+    return (uint16_t)(TXBUF_Size(b) - 1 - TXBUF_Used(b));
+}
+
+void Serial_Puts(uint8_t com, const char *str)
+{
+    TXBUF_Puts(&serial_ports[com].tx, str);
+}
+
+void Serial_Putc(uint8_t com, char c)
+{
+    TXBUF_Send(&serial_ports[com].tx, &c, 1);
+}
+
+void Serial_Flush(uint8_t com)
+{
+    TXBUF_Flush(&serial_ports[com].tx);
+}
+
+//------------------------------------------------------------------------------
+// Zmena rychlosti za behu - co uz je v bufferu, odejde jeste starou rychlosti.
+// Pri neproveditelne rychlosti (odchylka > SERIAL_BAUD_ERR_MAX_PPM) zustava stara.
+//------------------------------------------------------------------------------
+bool Serial_SetBaud(uint8_t com, uint32_t baud)
+{
+    Serial_Flush(com);
+    return serial_set_baud(&serial_ports[com], baud);
+}
+
+//------------------------------------------------------------------------------
+// Prijate davky portu s obsluhou znaku/radku - radek konci CR
+//------------------------------------------------------------------------------
+static void serial_poll_port(uint8_t com)
+{
+    serial_port *p = &serial_ports[com];
+    char chunk[64];
+    uint16_t n;
+
+    while (RXBUF_Ready(&p->rx)) {
+        n = RXBUF_Read(&p->rx, chunk, sizeof(chunk));
+        for (uint16_t i = 0; i < n; i++) {
+            char data = chunk[i];
+            if (data == 13) {
+                p->line[p->line_len] = '\0';
+                if (p->on_line) p->on_line(com, p->line, p->line_len);
+                p->line_len = 0;
+            } else {
+                if (p->on_char) p->on_char(com, data);
+                if (p->line_len < BUFFER_SIZE - 1) p->line[p->line_len++] = data;
+                else p->rx.line_drops++;
+            }
+        }
+    }
+}
+
+void Serial_Poll(void)
+{
+    for (uint8_t com = 0; com < SERIAL_PORTS; com++) {
+        if (serial_ports[com].on_char || serial_ports[com].on_line) {
+            serial_poll_port(com);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Stav bufferu vsech portu (prikaz 'u')
+//------------------------------------------------------------------------------
+void Serial_ShowStats(void)
+{
+    char txt[100];
+
+    for (uint8_t com = 0; com < SERIAL_PORTS; com++) {
+        const serial_port *p = &serial_ports[com];
+        sprintf(txt, " %s BAUD: %lu OVS%u skutecne=%lu (%ld ppm)\r\n", p->name,
+                (unsigned long)p->baud, p->ovs, (unsigned long)p->baud_actual, (long)p->baud_err_ppm);
+        sendStringUART1(txt);
+        sprintf(txt, " %s TX: used=%u max=%u/%u waits=%lu dropped=%lu dma=%lu\r\n", p->name,
+                TXBUF_Used(&p->tx), p->tx.hwm, TXBUF_Size(&p->tx), (unsigned long)p->tx.waits,
+                (unsigned long)p->tx.dropped, (unsigned long)p->tx.dma_xfers);
+        sendStringUART1(txt);
+        sprintf(txt, " %s RX: max=%u/%u bursts=%lu overruns=%lu line_drops=%lu\r\n", p->name,
+                p->rx.hwm, RXBUF_Size(&p->rx), (unsigned long)p->rx.bursts,
+                (unsigned long)p->rx.overruns, (unsigned long)p->rx.line_drops);
+        sendStringUART1(txt);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Preruseni - RX jen timeout (TCMP1), TX jen v rezimu bez LDMA (TXBL)
+//------------------------------------------------------------------------------
+void UART0_RX_IRQHandler(void)  { RXBUF_IRQHandler(&serial_ports[SERIAL_COM_A].rx); }
+void UART0_TX_IRQHandler(void)  { TXBUF_IRQHandler(&serial_ports[SERIAL_COM_A].tx); }
+void UART1_RX_IRQHandler(void)  { RXBUF_IRQHandler(&serial_ports[SERIAL_COM_B].rx); }
+void UART1_TX_IRQHandler(void)  { TXBUF_IRQHandler(&serial_ports[SERIAL_COM_B].tx); }
+void USART0_RX_IRQHandler(void) { RXBUF_IRQHandler(&serial_ports[SERIAL_COM_C].rx); }
+void USART0_TX_IRQHandler(void) { TXBUF_IRQHandler(&serial_ports[SERIAL_COM_C].tx); }
@@ -0,0 +1,79 @@
+/******************************************************************************
+ * @file serial.h
+ * @brief Spolecny ovladac seriovych portu COM-A/B/C - tabulka popisu portu
+ *****************************************************************************/
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ports.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_usart.h"
+#include "txbuf.h"
+#include "rxbuf.h"
+
+#define SERIAL_BAUD_ERR_MAX_PPM  20000   // vetsi odchylku (2%) Serial_SetBaud() odmitne
+
+//--- Porty v tabulce serial_ports[]
+enum {
+    SERIAL_COM_A,       // UART0  - TCI COM1-A
+    SERIAL_COM_B,       // UART1  - TCI COM2-B, ladici vypisy a prikazy
+    SERIAL_COM_C,       // USART0 - TCI COM3-C
+    SERIAL_PORTS
+};
+
+typedef void (*serial_char_fn)(uint8_t com, char c);
+typedef void (*serial_line_fn)(uint8_t com, char *line, uint16_t len);
+
+//--- Popis jednoho portu - konfigurace, buffery a stav skladani radku
+typedef struct {
+    const char        *name;
+    USART_TypeDef     *usart;
+    CMU_Clock_TypeDef  clock;
+    GPIO_Port_TypeDef  tx_port;
+    uint8_t            tx_pin;
+    GPIO_Port_TypeDef  rx_port;
+    uint8_t            rx_pin;
+    uint8_t            location;       // ROUTELOC0 pro TX i RX
+    uint32_t           baud;           // pozadovana rychlost
+    uint32_t           baud_actual;    // skutecna rychlost z CLKDIV
+    int32_t            baud_err_ppm;   // odchylka skutecne od pozadovane
+    uint8_t            ovs;            // prevzorkovani 16/8/6/4
+    IRQn_Type          rx_irq;
+    IRQn_Type          tx_irq;
+    uint8_t            tx_dma_ch;
+    uint32_t           tx_dma_signal;
+    uint8_t            rx_dma_ch;
+    uint32_t           rx_dma_signal;
+    serial_char_fn     on_char;        // kazdy prijaty znak krome CR, NULL = nic
+    serial_line_fn     on_line;        // radek ukonceny CR, NULL = port cte Serial_Read()
+    txbuf              tx;
+    rxbuf              rx;
+    char               line[BUFFER_SIZE];
+    uint16_t           line_len;
+} serial_port;
+
+extern serial_port serial_ports[SERIAL_PORTS];
+
+void     initSerial(void);                          // vsechny porty z tabulky, LDMA uz bezi
+void     Serial_DefaultHandlers(uint8_t com);
+void     Serial_SetHandlers(uint8_t com, serial_char_fn on_char, serial_line_fn on_line);
+uint16_t Serial_Write(uint8_t com, const char *data, uint16_t len);  // neblokujici, vraci prijate bajty
+uint16_t Serial_Read(uint8_t com, char *out, uint16_t max);         // neblokujici, vraci prectene bajty
+uint16_t Serial_TxFree(uint8_t com);                                // volne misto v bufferu vysilani
+void     Serial_Puts(uint8_t com, const char *str);                 // pri plnem bufferu ceka (mimo ISR)
+void     Serial_Putc(uint8_t com, char c);
+void     Serial_Flush(uint8_t com);
+bool     Serial_SetBaud(uint8_t com, uint32_t baud);   // dobehne vysilani, pak prepne
+void     Serial_Poll(void);                         // skladani radku, z hlavni smycky
+void     Serial_ShowStats(void);
+
+//--- Puvodni jmena z uart0.c, uart1.c a usart0.c
+#define sendStringUART0(s)   Serial_Puts(SERIAL_COM_A, (s))
+#define sendStringUART1(s)   Serial_Puts(SERIAL_COM_B, (s))
+#define sendStringUSART0(s)  Serial_Puts(SERIAL_COM_C, (s))
+#define sendCharUART1(c)     Serial_Putc(SERIAL_COM_B, (c))
+
+#endif /* SERIAL_H */
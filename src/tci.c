@@ -0,0 +1,414 @@
+/******************************************************************************
+ * @file tci.c
+ * @brief Prikazovy radek TCI na COM-B (UART1)
+ *
+ * Preruseni UART jen plni kruhovy buffer (LDMA, rxbuf.c). Serial_Poll() v hlavni
+ * smycce sklada radky a hotovy radek tady jen zaradi do fronty. TCI_Process()
+ * radek rozdeli na slova a podle prvniho slova najde prikaz v tabulce
+ * tci_commands[]. Tabulka nese i pocet argumentu (min..max) a napovedu, takze
+ * handler dostane uz zkontrolovany pocet slov.
+ *
+ *   set next_time 3
+ *   route add 15 * * 2 2 2
+ *   baud B 921600
+ *
+ * Puvodni jednoznakove prikazy (h, p, u, 1..6, t, T, x) zustavaji jako nazvy.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "tci.h"
+#include "ports.h"
+#include "serial.h"
+#include "hostlink.h"
+#include "parameters.h"
+#include "pocsag.h"
+#include "inputs.h"
+#include "timer1.h"
+#include "timer2.h"
+#include "led.h"
+
+#include "em_gpio.h"
+
+typedef struct {
+    const char *name;
+    uint8_t     min_args;       // argumenty bez nazvu prikazu
+    uint8_t     max_args;
+    void      (*handler)(uint8_t argc, char **argv);
+    const char *usage;
+} tci_command;
+
+static void cmd_help(uint8_t argc, char **argv);
+
+//-- Fronta radku z Serial_Poll() pro TCI_Process()
+static char     tci_queue[TCI_QUEUE_LINES][BUFFER_SIZE];
+static uint8_t  tci_head = 0;
+static uint8_t  tci_tail = 0;
+static uint32_t tci_dropped = 0;
+
+//------------------------------------------------------------------------------
+// Cteni cisla z argumentu - cele slovo musi byt cislo v rozsahu min..max
+//------------------------------------------------------------------------------
+static bool tci_number(const char *arg, uint32_t min, uint32_t max, uint32_t *value)
+{
+    char *end;
+    unsigned long v = strtoul(arg, &end, 0);
+
+    if (end == arg || *end != '\0' || v < min || v > max) {
+        char txt[80];
+        sprintf(txt, "chybna hodnota '%s' (%lu..%lu)\r\n", arg, (unsigned long)min, (unsigned long)max);
+        sendStringUART1(txt);
+        return false;
+    }
+    *value = (uint32_t)v;
+    return true;
+}
+
+//-- '*' v route = libovolna hodnota (255)
+static bool tci_wild(const char *arg, uint32_t min, uint32_t max, uint32_t *value)
+{
+    if (strcmp(arg, "*") == 0) {
+        *value = 255;
+        return true;
+    }
+    return tci_number(arg, min, max, value);
+}
+
+//------------------------------------------------------------------------------
+//  Jednoduche prikazy
+//------------------------------------------------------------------------------
+static void cmd_params(uint8_t argc, char **argv)
+{
+    Parameters_Show();
+}
+
+static void cmd_stats(uint8_t argc, char **argv)
+{
+    char txt[60];
+
+    Serial_ShowStats();
+    HOST_ShowStats();
+    sprintf(txt, " TCI: zahozeno radku=%lu\r\n", (unsigned long)tci_dropped);
+    sendStringUART1(txt);
+}
+
+static void cmd_led(uint8_t argc, char **argv)
+{
+    switch (argv[0][0]) {
+        case '1': LED1_Toggle();
+                  GPIO_PinOutToggle(DBG_PORT, DBG_PIN);
+                  sendStringUART1("LED1");
+                  break;
+        case '2': LED2_Toggle();   sendStringUART1("LED2");   break;
+        case '3': LED3_Toggle();   sendStringUART1("LED3");   break;
+        case '4': LED4_Toggle();   sendStringUART1("LED4");   break;
+        case '5': LED_RX_Toggle(); sendStringUART1("LED RX"); break;
+        case '6': LED_TX_Toggle(); sendStringUART1("LED TX"); break;
+    }
+}
+
+static void cmd_tx(uint8_t argc, char **argv)
+{
+    if (POCSAG_tx_repeat()) sendStringUART1("Tx datagram -> TXQ\r\n");
+    else                    sendStringUART1("Tx datagram: neni token / fronta plna\r\n");
+}
+
+static void cmd_timer_stop(uint8_t argc, char **argv)
+{
+    TIMER1_Stop();
+    sendStringUART1("Stop timer1 TX 1200Hz\r\n");
+}
+
+static void cmd_edge(uint8_t argc, char **argv)
+{
+    sendStringUART1("RX edge sync on\r\n");
+    rx_edge_sync_on();
+}
+
+//------------------------------------------------------------------------------
+//  baud A|B|C <rychlost> - zmena rychlosti portu za behu
+//------------------------------------------------------------------------------
+static void cmd_baud(uint8_t argc, char **argv)
+{
+    char txt[100];
+    uint32_t baud;
+    uint8_t port;
+
+    switch (argv[1][0]) {
+        case 'A': case 'a': port = SERIAL_COM_A; break;
+        case 'B': case 'b': port = SERIAL_COM_B; break;
+        case 'C': case 'c': port = SERIAL_COM_C; break;
+        default:
+            sendStringUART1("port A|B|C\r\n");
+            return;
+    }
+    if (argv[1][1] != '\0' || !tci_number(argv[2], 300, 1000000, &baud)) return;
+
+    sprintf(txt, "BAUD COM-%c -> %lu\r\n", 'A' + port, (unsigned long)baud);
+    sendStringUART1(txt);
+    if (!Serial_SetBaud(port, baud)) {
+        sendStringUART1("nelze nastavit\r\n");
+        return;
+    }
+    const serial_port *p = &serial_ports[port];
+    sprintf(txt, "BAUD COM-%c: OVS%u skutecne=%lu (%ld ppm)\r\n", 'A' + port, p->ovs,
+            (unsigned long)p->baud_actual, (long)p->baud_err_ppm);
+    sendStringUART1(txt);
+}
+
+//------------------------------------------------------------------------------
+//  set <parametr> <hodnota> - jednoduche polozky param
+//  host_port 0|1|3 - po zmene se port hned prevezme / vrati (HOST_Init)
+//------------------------------------------------------------------------------
+typedef struct {
+    const char *name;
+    void       *value;
+    uint8_t     size;           // 1 = unsigned char, 2 = unsigned short, 4 = unsigned long
+    uint32_t    min;
+    uint32_t    max;
+} tci_param;
+
+static const tci_param tci_params[] = {
+    { "primary_net",    &param.primary_net,    1, 1,   MAX_NETS },
+    { "next_time",      &param.next_time,      1, 0,   255 },
+    { "next_rpt",       &param.next_rpt,       1, 0,   255 },
+    { "error_rpt",      &param.error_rpt,      1, 0,   255 },
+    { "pretime",        &param.pretime,        4, 0,   TIMER2_MAX_US },   // us
+    { "deadtime",       &param.deadtime,       4, 0,   TIMER2_MAX_US },
+    { "sys_tok",        &param.sys_tok,        1, 0,   1 },
+    { "sync_err",       &param.sync_err,       1, 0,   POCSAG_SYNC_ERR_MAX },
+    { "tx_rate",        &param.tx_rate,        2, 0,   2400 },
+    { "preamble",       &param.preamble,       2, POCSAG_PREAMBLE_MIN, POCSAG_PREAMBLE_MAX },
+    { "preamble_adapt", &param.preamble_adapt, 1, 0,   1 },
+    { "host_port",      &param.host_port,      1, 0,   3 },
+};
+
+static void cmd_set(uint8_t argc, char **argv)
+{
+    uint32_t v;
+
+    for (uint8_t i = 0; i < sizeof(tci_params) / sizeof(tci_params[0]); i++) {
+        const tci_param *p = &tci_params[i];
+        if (strcmp(argv[1], p->name) != 0) continue;
+
+        if (!tci_number(argv[2], p->min, p->max, &v)) return;
+        if (p->value == &param.tx_rate && v != 0 && v != 512 && v != 1200 && v != 2400) {
+            sendStringUART1("tx_rate 0|512|1200|2400\r\n");
+            return;
+        }
+        if (p->value == &param.preamble && (v % 32) != 0) {
+            char txt[60];
+            v &= ~31UL;     // vysila se po celych slovech (tx_serialize)
+            sprintf(txt, "preamble zaokrouhlena na %lu\r\n", (unsigned long)v);
+            sendStringUART1(txt);
+        }
+        if (p->value == &param.host_port && v == 2) {
+            sendStringUART1("host_port 0|1|3 (COM-B je konzole)\r\n");
+            return;
+        }
+        if      (p->size == 4) *(unsigned long *)p->value  = v;
+        else if (p->size == 2) *(unsigned short *)p->value = (unsigned short)v;
+        else                   *(unsigned char *)p->value  = (unsigned char)v;
+        if (p->value == &param.host_port) HOST_Init();
+        sendStringUART1("OK\r\n");
+        return;
+    }
+
+    sendStringUART1("parametry:");
+    for (uint8_t i = 0; i < sizeof(tci_params) / sizeof(tci_params[0]); i++) {
+        sendStringUART1(" ");
+        sendStringUART1(tci_params[i].name);
+    }
+    sendStringUART1("\r\n");
+}
+
+//------------------------------------------------------------------------------
+//  net <net> <dau> - DAU site (0 = zadny)
+//------------------------------------------------------------------------------
+static void cmd_net(uint8_t argc, char **argv)
+{
+    uint32_t net, dau;
+
+    if (!tci_number(argv[1], 1, MAX_NETS, &net)) return;
+    if (!tci_number(argv[2], 0, 255, &dau)) return;
+    param.netdau[net - 1] = (unsigned char)dau;
+    sendStringUART1("OK\r\n");
+}
+
+//------------------------------------------------------------------------------
+//  route add <net> <path|*> <dau|*> <flw> <err> <rev>
+//  route del <n>     (n = radek 1..MAX_ROUTES ve vypisu 'p')
+//  route clr
+//  Tabulka konci prvnim radkem s path == 0, proto se pri mazani posouva.
+//  Cte ji make_route() pri kazdem tokenu pro tuto stanici - plati hned.
+//------------------------------------------------------------------------------
+static uint8_t route_count(void)
+{
+    uint8_t n = 0;
+    while (n < MAX_ROUTES && param.route[n].path != 0) n++;
+    return n;
+}
+
+static void cmd_route(uint8_t argc, char **argv)
+{
+    uint8_t  count = route_count();
+    uint32_t v[6];
+
+    if (strcmp(argv[1], "add") == 0 && argc == 8) {
+        if (count >= MAX_ROUTES) {
+            sendStringUART1("tabulka je plna\r\n");
+            return;
+        }
+        if (!tci_number(argv[2], 1, MAX_NETS, &v[0])) return;
+        if (!tci_wild(argv[3], 1, 254, &v[1]))        return;
+        if (!tci_wild(argv[4], 0, 254, &v[2]))        return;
+        for (uint8_t i = 3; i < 6; i++) {
+            if (!tci_number(argv[i + 2], 0, 255, &v[i])) return;
+        }
+        tci_routes *r = &param.route[count];
+        r->net    = (unsigned char)v[0];
+        r->path   = (unsigned char)v[1];
+        r->dau    = (unsigned char)v[2];
+        r->follow = (unsigned char)v[3];
+        r->error  = (unsigned char)v[4];
+        r->revers = (unsigned char)v[5];
+    }
+    else if (strcmp(argv[1], "del") == 0 && argc == 3) {
+        if (!tci_number(argv[2], 1, count, &v[0])) return;
+        for (uint8_t i = (uint8_t)v[0] - 1; i < MAX_ROUTES - 1; i++) {
+            param.route[i] = param.route[i + 1];
+        }
+        memset(&param.route[MAX_ROUTES - 1], 0, sizeof(tci_routes));
+    }
+    else if (strcmp(argv[1], "clr") == 0 && argc == 2) {
+        memset(param.route, 0, sizeof(param.route));
+    }
+    else {
+        sendStringUART1("route add <net> <path|*> <dau|*> <flw> <err> <rev> | del <n> | clr\r\n");
+        return;
+    }
+    sendStringUART1("OK\r\n");
+}
+
+//------------------------------------------------------------------------------
+//  Tabulka prikazu - nazev, min..max argumentu, obsluha, napoveda
+//------------------------------------------------------------------------------
+static const tci_command tci_commands[] = {
+    { "h",     0, 0, cmd_help,       ": display this help" },
+    { "p",     0, 0, cmd_params,     ": show parameters" },
+    { "u",     0, 0, cmd_stats,      ": UART TX/RX buffers" },
+    { "1",     0, 0, cmd_led,        ": toggle LED1 (2..6 LED2..4, RX, TX)" },
+    { "2",     0, 0, cmd_led,        NULL },
+    { "3",     0, 0, cmd_led,        NULL },
+    { "4",     0, 0, cmd_led,        NULL },
+    { "5",     0, 0, cmd_led,        NULL },
+    { "6",     0, 0, cmd_led,        NULL },
+    { "t",     0, 0, cmd_tx,         ": queue last TX TOKEN again" },
+    { "T",     0, 0, cmd_timer_stop, ": stop timer1 1200Hz" },
+    { "x",     0, 0, cmd_edge,       ": RX edges sync TIMER1 phase" },
+    { "baud",  2, 2, cmd_baud,       "A|B|C <rate> : port speed (9600..921600)" },
+    { "set",   2, 2, cmd_set,        "<name> <value> : set parameter" },
+    { "net",   2, 2, cmd_net,        "<net> <dau> : DAU of net (0 = none)" },
+    { "route", 1, 7, cmd_route,      "add <net> <path|*> <dau|*> <flw> <err> <rev> | del <n> | clr" },
+    { NULL,    0, 0, NULL,           NULL }
+};
+
+static void cmd_help(uint8_t argc, char **argv)
+{
+    char txt[100];
+
+    sendStringUART1("help\r\n");
+    sendStringUART1(" --------------------------------\r\n");
+    sendStringUART1(" TCI commands:\r\n");
+    sendStringUART1(" --------------------------------\r\n");
+    for (const tci_command *c = tci_commands; c->name != NULL; c++) {
+        if (c->usage == NULL) continue;
+        sprintf(txt, " %s %s\r\n", c->name, c->usage);
+        sendStringUART1(txt);
+    }
+    sendStringUART1(" --------------------------------\r\n");
+    POCSAG_show_rx_state();
+    sendStringUART1(" --------------------------------\r\n");
+}
+
+//------------------------------------------------------------------------------
+// Rozdeli radek na slova (mezery/taby), vraci pocet slov
+//------------------------------------------------------------------------------
+static uint8_t tci_split(char *line, char **argv)
+{
+    uint8_t argc = 0;
+
+    while (*line != '\0') {
+        while (*line == ' ' || *line == '\t') *line++ = '\0';
+        if (*line == '\0') break;
+        if (argc == TCI_ARGS_MAX) return TCI_ARGS_MAX + 1;    // prilis mnoho slov
+        argv[argc++] = line;
+        while (*line != '\0' && *line != ' ' && *line != '\t') line++;
+    }
+    return argc;
+}
+
+static void tci_execute(char *line)
+{
+    char *argv[TCI_ARGS_MAX];
+    uint8_t argc = tci_split(line, argv);
+
+    if (argc == 0) return;
+    if (argc > TCI_ARGS_MAX) {
+        sendStringUART1("prilis mnoho argumentu\r\n");
+        return;
+    }
+
+    for (const tci_command *c = tci_commands; c->name != NULL; c++) {
+        if (strcmp(argv[0], c->name) != 0) continue;
+        if (argc - 1 < c->min_args || argc - 1 > c->max_args) {
+            const tci_command *u = c;
+            while (u->usage == NULL) u--;       // LED 2..6 sdili napovedu s '1'
+            sendStringUART1(c->name);
+            sendStringUART1(" ");
+            sendStringUART1(u->usage);
+            sendStringUART1("\r\n");
+            return;
+        }
+        c->handler(argc, argv);
+        return;
+    }
+    sendStringUART1("neznamy prikaz, h = help\r\n");
+}
+
+//------------------------------------------------------------------------------
+// Obsluha COM-B z Serial_Poll() - echo znaku, hotovy radek do fronty
+//------------------------------------------------------------------------------
+static void tci_char(uint8_t com, char c)
+{
+    Serial_Putc(com, c);
+}
+
+static void tci_line(uint8_t com, char *line, uint16_t len)
+{
+    uint8_t next = (uint8_t)((tci_head + 1) % TCI_QUEUE_LINES);
+
+    Serial_Puts(com, "\r\n");
+    if (next == tci_tail) {
+        tci_dropped++;
+        return;
+    }
+    memcpy(tci_queue[tci_head], line, len + 1);     // vcetne '\0'
+    tci_head = next;
+}
+
+void TCI_Init(void)
+{
+    Serial_SetHandlers(SERIAL_COM_B, tci_char, tci_line);
+}
+
+void TCI_Process(void)
+{
+    while (tci_tail != tci_head) {
+        tci_execute(tci_queue[tci_tail]);
+        tci_tail = (uint8_t)((tci_tail + 1) % TCI_QUEUE_LINES);
+        sendStringUART1("\r\nTCI> ");
+    }
+}
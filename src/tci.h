@@ -0,0 +1,16 @@
+/******************************************************************************
+ * Prikazovy radek TCI na COM-B - cele radky, tabulka prikazu
+ *****************************************************************************/
+
+#ifndef TCI_H
+#define TCI_H
+
+#include <stdint.h>
+
+#define TCI_QUEUE_LINES  4      // radky cekajici na hlavni smycku
+#define TCI_ARGS_MAX     8      // nazev prikazu + argumenty
+
+void TCI_Init(void);            // pred initSerial() - prevezme COM-B
+void TCI_Process(void);         // hlavni smycka - vykona radky z fronty
+
+#endif /* TCI_H */
@@ -11,32 +11,61 @@
  * 		To zarucuje co nejpresnejsi kalibraci rychlosti.
  * 		Co bylo namereno bude i nastaveno.
  *
- * TIMER1 taktuje POCSAG_SampleBit() 1200x za sekundu.
- * Uvnit POCSAG_SampleBit() se odete RX
- * Sted bitu - Synchronizaci fze zajiuje POCSAG_edge_detected() volan
- * z GPIO_EVEN_IRQHandler pi hran signlu na PA0.
+ * TIMER1 taktuje POCSAG_sample_bit() 1200x za sekundu (512/2400 bps podle
+ * detekovane rychlosti prijmu, viz TIMER1_SetRate()).
+ * Stred bitu se vzorkuje v POCSAG_sample_bit(). Fazi synchronizuji hrany RX
+ * zachycene WTIMER0 (PRS + LDMA), Input_ProcessEdges() je zpracuje na zacatku
+ * TIMER1_IRQHandler (viz rx_edge_sync_on/off v inputs.c).
  *****************************************************************************/
 #include "timer1.h"
 #include "ports.h"
 #include "pocsag.h"
 #include "led.h"
+#include "inputs.h"
 
 #include "em_cmu.h"
 #include "em_timer.h"
 #include "em_gpio.h"
 
+static uint16_t timer1_bps = POCSAG_BPS_DEFAULT;  // rychlost prijmu
+static uint8_t  timer1_presc = 0;                 // preddelic TIMER1 = 2^timer1_presc
+static volatile uint32_t timer1_isr_max = 0;      // nejdelsi obsluha preruseni (takty)
+
+//------------------------------------------------------------------------------
+// Nastavi periodu TIMER1 v tikach 72MHz, preddelic jen kdyz TOP nevejde do 16 bitu
+//------------------------------------------------------------------------------
+static void timer1_set(uint32_t ticks)
+{
+    uint8_t presc = 0;
+    while ((ticks >> presc) > 0x10000) presc++;
+
+    if (presc != timer1_presc) {
+        timer1_presc = presc;
+        TIMER1->CTRL = (TIMER1->CTRL & ~_TIMER_CTRL_PRESC_MASK)
+                     | ((uint32_t)presc << _TIMER_CTRL_PRESC_SHIFT);
+        TIMER1->CNT  = 0;
+    }
+    TIMER1->TOP = (ticks >> presc) - 1;
+}
+
 void initTIMER1(void)
 {
     CMU_ClockEnable(cmuClock_TIMER1, true);
 
     TIMER1->CTRL = 0;
     TIMER1->CNT  = 0;
-    TIMER1->TOP  = TIMER1_TOP;
 //    TIMER1->CTRL = TIMER_CTRL_PRESC_DIV16 | TIMER_CTRL_MODE_UP;
     TIMER1->CTRL = TIMER_CTRL_PRESC_DIV1 | TIMER_CTRL_MODE_UP;
+    timer1_presc = 0;
+    TIMER1_ResetSpeed();
     TIMER1->IFC  = _TIMER_IFC_MASK;
     TIMER1->IEN  = TIMER_IEN_OF;
 
+    //-- Citac taktu CPU pro mereni doby obsluhy preruseni - jen zapnout,
+    //   nenulovat (merene useky jsou rozdily, nulovani uprostred mereni vadi)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+
     // Zsadn: Povolen v NVIC, jinak se IRQHandler nikdy nezavol
 	NVIC_ClearPendingIRQ(TIMER1_IRQn);
 	NVIC_EnableIRQ(TIMER1_IRQn);
@@ -60,12 +89,36 @@ void TIMER1_Stop(void)
 }
 
 void TIMER1_IRQHandler(void) {
+    uint32_t start = DWT->CYCCNT;
+
     TIMER1->IFC = TIMER_IFC_OF;
+    Input_ProcessEdges(); // Hrany RX zachycene WTIMER0 od minuleho tiku
     POCSAG_sample_bit(); // Tato funkce e RX/TX jednoho bitu.
 //    LED2_Toggle();
 //    LED_TX_Off();
 //    GPIO_PinOutToggle(DBG_PORT, DBG_PIN);
 
+    uint32_t cycles = DWT->CYCCNT - start;
+    if (cycles > timer1_isr_max) timer1_isr_max = cycles;
+}
+
+//------------------------------------------------------------------------------
+// Nejhorsi doba obsluhy preruseni - kontroluje hlavni smycka
+// HFCLK = 72MHz, takze takty CPU jsou ve stejnych jednotkach jako perioda.
+//------------------------------------------------------------------------------
+uint32_t TIMER1_IsrMax(void)
+{
+    return timer1_isr_max;
+}
+
+void TIMER1_IsrMaxReset(void)
+{
+    timer1_isr_max = 0;
+}
+
+bool TIMER1_IsrOverBudget(void)
+{
+    return (uint64_t)timer1_isr_max * 100 > (uint64_t)TIMER1_Period() * TIMER1_ISR_BUDGET_PCT;
 }
 
 //------------------------------------------------------------------------------
@@ -74,19 +127,84 @@ void TIMER1_IRQHandler(void) {
 // TOP = (72M / f) -1
 // pro f=1200Hz to je 60000-1
 // pri vzorkovani 72MHz je TOP kalibrovane s presnosti +/- 13,88nsec
+// (pri 512 bps je TIMER1 s preddelicem 4, tj. +/- 55,5nsec)
 //------------------------------------------------------------------------------
 void TIMER1_Calibrate(uint32_t calib_counter)
 {
-	//-- Ochrana, kalibrujeme jen pri odchylce +/-24Hz (2%) t.j. <1176,1224>Hz
+	uint32_t nominal = TIMER1_Nominal();
+
+	//-- Ochrana, kalibrujeme jen pri odchylce +/-2% t.j. pro 1200 bps <1176,1224>Hz
 	//   Norma povoluje max. odchylku 10ppm (0,012 bps)
 	//   povolen je rozsah 1199,988 a 1200,012 Hz
-	if (calib_counter>58823 && calib_counter<61177) {
+	if (calib_counter>TIMER1_CALIB_MIN(nominal) && calib_counter<TIMER1_CALIB_MAX(nominal)) {
 //		TIMER1->TOP = ((calib_counter/16)+0.5)-1;
-		TIMER1->TOP = calib_counter - 1;
+		TIMER1_SetPeriod(calib_counter / TIMER1_RX_DIV);
 	}
 }
 
+//------------------------------------------------------------------------------
+// Vychozi rychlost pro prijem (pri prevzorkovani N-nasobek bitove rychlosti)
+//------------------------------------------------------------------------------
 void TIMER1_ResetSpeed(void)
 {
-    TIMER1->TOP  = TIMER1_TOP;
+    timer1_set(TIMER1_Nominal() / TIMER1_RX_DIV);
+}
+
+//------------------------------------------------------------------------------
+// Bitova rychlost pro vysilani
+//------------------------------------------------------------------------------
+void TIMER1_TxSpeed(uint16_t bps)
+{
+    timer1_set(TIMER1_BIT_TICKS(bps));
+}
+
+//------------------------------------------------------------------------------
+// Navrat na periodu prijmu po vysilani - vcetne preddelice, ktery mohl
+// vysilani zmenit (512 bps)
+//------------------------------------------------------------------------------
+void TIMER1_RxSpeed(uint32_t ticks)
+{
+    timer1_set(ticks);
+}
+
+//------------------------------------------------------------------------------
+// Rychlost prijmu - nastavuje detekce rychlosti z preamble
+//------------------------------------------------------------------------------
+void TIMER1_SetRate(uint16_t bps)
+{
+    timer1_bps = bps;
+    TIMER1_ResetSpeed();
+}
+
+uint16_t TIMER1_Rate(void)
+{
+    return timer1_bps;
+}
+
+uint32_t TIMER1_Nominal(void)
+{
+    return TIMER1_BIT_TICKS(timer1_bps);
+}
+
+//------------------------------------------------------------------------------
+// Perioda a citac TIMER1 v tikach 72MHz (nezavisle na preddelici)
+//------------------------------------------------------------------------------
+uint32_t TIMER1_Period(void)
+{
+    return (TIMER1->TOP + 1) << timer1_presc;
+}
+
+void TIMER1_SetPeriod(uint32_t ticks)
+{
+    TIMER1->TOP = (ticks >> timer1_presc) - 1;
+}
+
+uint32_t TIMER1_Count(void)
+{
+    return TIMER1->CNT << timer1_presc;
+}
+
+void TIMER1_SetCount(uint32_t ticks)
+{
+    TIMER1->CNT = ticks >> timer1_presc;
 }
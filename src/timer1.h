@@ -6,16 +6,52 @@
 #define TIMER1_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "pocsag.h"   /* POCSAG_RX_OVERSAMPLE */
 
 /* 2400 Hz: 72 000 000 / 16 / 2400 - 1 = 1874 */
 /* 1200 Hz: 3749 pi 72MHz a div16 */
 //#define TIMER1_TOP  (72000000UL / 16 / 1200 - 1)
-#define TIMER1_TOP  (72000000UL / 1200 - 1)
+//#define TIMER1_TOP  (72000000UL / 1200 - 1)
+
+/* Periody se pocitaji v tikach 72MHz (stejne jako WTIMER0), preddelic TIMER1
+   se voli jen kdyz perioda nevejde do 16 bitu (512 bps = 140625 tiku) */
+#define TIMER1_CLK            72000000UL
+#define TIMER1_BIT_TICKS(bps) (TIMER1_CLK / (bps))
+#define POCSAG_BPS_DEFAULT    1200
+
+/* Prijem s prevzorkovanim: TIMER1 bezi na N-nasobku bitove rychlosti */
+#if POCSAG_RX_OVERSAMPLE
+#define TIMER1_RX_DIV  POCSAG_RX_OVERSAMPLE
+#else
+#define TIMER1_RX_DIV  1
+#endif
+
+/* Povolene rozpeti periody bitu pri kalibraci a sledovani (+/-2%),
+   p = nominalni perioda bitu v tikach 72MHz (1200 bps: 58824..61176) */
+#define TIMER1_CALIB_MIN(p)  ((p) - (p) / 51)
+#define TIMER1_CALIB_MAX(p)  ((p) + (p) / 51)
+
+/* Nejhorsi doba obsluhy TIMER1_IRQHandler (DWT CYCCNT, takty 72MHz)
+   nesmi prekrocit tuto cast periody preruseni */
+#define TIMER1_ISR_BUDGET_PCT  10
 
 void initTIMER1(void);
 void TIMER1_Start(void);
 void TIMER1_Stop(void);
 void TIMER1_Calibrate(uint32_t calib_counter);
 void TIMER1_ResetSpeed(void);
+void TIMER1_TxSpeed(uint16_t bps);
+void TIMER1_RxSpeed(uint32_t ticks);    // perioda prijmu po vysilani (bez initTIMER1)
+void TIMER1_SetRate(uint16_t bps);      // rychlost prijmu (512/1200/2400)
+uint16_t TIMER1_Rate(void);
+uint32_t TIMER1_Nominal(void);          // nominalni perioda bitu prijmu v tikach 72MHz
+uint32_t TIMER1_Period(void);           // aktualni perioda TIMER1 v tikach 72MHz
+void TIMER1_SetPeriod(uint32_t ticks);
+uint32_t TIMER1_Count(void);            // CNT v tikach 72MHz
+void TIMER1_SetCount(uint32_t ticks);
+uint32_t TIMER1_IsrMax(void);           // nejdelsi obsluha preruseni v taktech
+void TIMER1_IsrMaxReset(void);
+bool TIMER1_IsrOverBudget(void);        // max > TIMER1_ISR_BUDGET_PCT periody
 
 #endif /* TIMER1_H */
@@ -0,0 +1,58 @@
+/******************************************************************************
+ * @file timer2.c
+ * @brief Obsluha TIMER2 - jednorazove casovani PTT
+ * @note HFCLK = 72 MHz, PRESC = DIV1024, jednorazovy beh (OSMEN)
+ *
+ * Vysilac po zaklicovani potrebuje cas na nabeh (param.pretime) a po
+ * poslednim bitu jeste chvili drzi nosnou (param.deadtime). TIMER2 odmeri
+ * tyto casy nezavisle na hlavni smycce a TIMER1 - po preteceni se zastavi
+ * a zavola POCSAG_ptt_timer().
+ *****************************************************************************/
+#include "timer2.h"
+#include "pocsag.h"
+#include "em_cmu.h"
+#include "em_timer.h"
+
+void initTIMER2(void)
+{
+    CMU_ClockEnable(cmuClock_TIMER2, true);
+
+    TIMER2->CTRL = 0;
+    TIMER2->CNT  = 0;
+    TIMER2->CTRL = TIMER_CTRL_PRESC_DIV1024 | TIMER_CTRL_MODE_UP | TIMER_CTRL_OSMEN;
+    TIMER2->IFC  = _TIMER_IFC_MASK;
+    TIMER2->IEN  = TIMER_IEN_OF;
+
+    NVIC_ClearPendingIRQ(TIMER2_IRQn);
+    NVIC_EnableIRQ(TIMER2_IRQn);
+}
+
+//------------------------------------------------------------------------------
+// Spusti jednorazove odmereni us mikrosekund (max. TIMER2_MAX_US)
+//------------------------------------------------------------------------------
+void TIMER2_OneShot(uint32_t us)
+{
+    uint32_t ticks = (uint32_t)(((uint64_t)us * 72000000UL / 1024 + 500000) / 1000000);
+
+    if (ticks == 0)      ticks = 1;
+    if (ticks > 0x10000) ticks = 0x10000;
+
+    TIMER2->CMD = TIMER_CMD_STOP;
+    TIMER2->CNT = 0;
+    TIMER2->TOP = ticks - 1;
+    TIMER2->IFC = _TIMER_IFC_MASK;
+    TIMER2->CMD = TIMER_CMD_START;
+}
+
+void TIMER2_Cancel(void)
+{
+    TIMER2->CMD = TIMER_CMD_STOP;
+    TIMER2->IFC = _TIMER_IFC_MASK;
+}
+
+void TIMER2_IRQHandler(void)
+{
+    TIMER2->IFC = TIMER_IFC_OF;
+    TIMER2->CMD = TIMER_CMD_STOP;   // OSMEN zastavi sam, pro jistotu
+    POCSAG_ptt_timer();
+}
@@ -0,0 +1,18 @@
+/******************************************************************************
+ * Obsluha TIMER2 - jednorazove casovani PTT (predstih a dobeh vysilace)
+ *****************************************************************************/
+
+#ifndef TIMER2_H
+#define TIMER2_H
+
+#include <stdint.h>
+
+/* 72 000 000 / 1024 = 70312,5 Hz -> rozliseni 14,2 us, max. 932 ms */
+#define TIMER2_TICKS_PER_MS  (72000000UL / 1024 / 1000)
+#define TIMER2_MAX_US        (65536ULL * 1024 * 1000000 / 72000000)
+
+void initTIMER2(void);
+void TIMER2_OneShot(uint32_t us);   // po us zavola POCSAG_ptt_timer()
+void TIMER2_Cancel(void);
+
+#endif /* TIMER2_H */
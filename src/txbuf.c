@@ -0,0 +1,182 @@
+/******************************************************************************
+ * @file txbuf.c
+ * @brief Kruhovy buffer vysilani UART/USART vyprazdnovany prerusenim TXBL nebo LDMA
+ *
+ * Puvodni sendStringXXX() cekaly u kazdeho bajtu na TXBL, takze vypis tokenu
+ * drzel hlavni smycku stovky ms (na COM-A 9600 Bd i sekundy). Ted se text
+ * jen zkopiruje do bufferu a odesila ho TX preruseni portu.
+ *
+ * Plny buffer:
+ *   TXBUF_Write() - vrati kolik se veslo, zbytek je na volajicim
+ *   TXBUF_Send()  - v hlavni smycce pocka na misto (pocita waits), v preruseni
+ *                   nebo pri zakazanych prerusenich zbytek zahodi (dropped)
+ *
+ * Rezim LDMA (TXBUF_InitDMA): misto preruseni na kazdy bajt odesila LDMA
+ * souvisly usek od tail, nejvyse polovinu bufferu. Do druhe poloviny mezitim
+ * zapisuje hlavni smycka (ping-pong), preruseni LDMA je jen jedno na usek -
+ * posune tail a spusti dalsi usek.
+ *****************************************************************************/
+#include "txbuf.h"
+#include "rxbuf.h"
+#include "inputs.h"
+#include "em_device.h"
+#include <string.h>
+
+#define TXBUF_DMA_MAX   2048   // max. delka jednoho deskriptoru (XFERCNT 11 bitu)
+#define TXBUF_LOCK_MAX  64     // max. bajtu zkopirovanych v jednom zakazu preruseni
+
+static txbuf *txbuf_dma[DMA_CHAN_COUNT];   // buffery podle kanalu LDMA
+
+//------------------------------------------------------------------------------
+// Spusti LDMA na dalsi souvisly usek bufferu - volat se zakazanym prerusenim
+//------------------------------------------------------------------------------
+static void txbuf_dma_start(txbuf *b) {
+    uint16_t tail = b->tail;
+    uint16_t head = b->head;
+    if (b->dma_len != 0 || head == tail) return;
+
+    uint16_t len = (head > tail) ? (uint16_t)(head - tail) : (uint16_t)(b->mask + 1 - tail);
+    if (len > (b->mask + 1) / 2) len = (uint16_t)((b->mask + 1) / 2);
+    if (len > TXBUF_DMA_MAX)     len = TXBUF_DMA_MAX;
+
+    b->dma_desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(&b->buf[tail], &b->usart->TXDATA, len);
+    LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(b->dma_signal);
+    b->dma_len = len;
+    b->dma_xfers++;
+    LDMA_StartTransfer(b->dma_ch, &cfg, &b->dma_desc);
+}
+
+//------------------------------------------------------------------------------
+// Prepne buffer na vysilani pres LDMA (LDMA_Init uz musi byt hotove)
+//------------------------------------------------------------------------------
+void TXBUF_InitDMA(txbuf *b, uint8_t ch, uint32_t signal) {
+    b->dma_ch = (int8_t)ch;
+    b->dma_signal = signal;
+    b->dma_len = 0;
+    txbuf_dma[ch] = b;
+}
+
+//------------------------------------------------------------------------------
+// Pocet bajtu cekajicich na odeslani
+//------------------------------------------------------------------------------
+uint16_t TXBUF_Used(const txbuf *b) {
+    return (uint16_t)((b->head - b->tail) & b->mask);
+}
+
+uint16_t TXBUF_Size(const txbuf *b) {
+    return (uint16_t)(b->mask + 1);
+}
+
+//------------------------------------------------------------------------------
+// Neblokujici zapis - vraci pocet prijatych bajtu (0..len)
+// Kopiruje se po TXBUF_LOCK_MAX bajtech, kazdy kus ve vlastnim zakazu
+// preruseni - velky zapis (ramec hostlink ~860 B) tak nezdrzi TIMER1 o desitky
+// us. Zapis z preruseni se muze vlozit mezi kusy, text se pak prolne.
+//------------------------------------------------------------------------------
+uint16_t TXBUF_Write(txbuf *b, const char *data, uint16_t len) {
+    uint16_t done = 0;
+
+    while (done < len) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        uint16_t used = (uint16_t)((b->head - b->tail) & b->mask);
+        uint16_t room = (uint16_t)(b->mask - used);   // jedno misto zustava volne
+        uint16_t n    = (uint16_t)(len - done);
+        if (n > room)           n = room;
+        if (n > TXBUF_LOCK_MAX) n = TXBUF_LOCK_MAX;
+
+        uint16_t head  = b->head;
+        uint16_t first = (uint16_t)(b->mask + 1 - head);   // do konce bufferu
+        if (first > n) first = n;
+        memcpy(&b->buf[head], &data[done], first);
+        memcpy(&b->buf[0], &data[done + first], n - first);
+        b->head = (uint16_t)((head + n) & b->mask);
+
+        used += n;
+        if (used > b->hwm) b->hwm = used;
+        if (n != 0) {
+            if (b->dma_ch >= 0) txbuf_dma_start(b);
+            else                USART_IntEnable(b->usart, USART_IEN_TXBL);
+        }
+
+        __set_PRIMASK(primask);
+        if (n == 0) break;
+        done = (uint16_t)(done + n);
+    }
+    return done;
+}
+
+//------------------------------------------------------------------------------
+// Zapis celych dat - kdyz neni misto, ceka (jen mimo preruseni)
+//------------------------------------------------------------------------------
+void TXBUF_Send(txbuf *b, const char *data, uint16_t len) {
+    bool can_wait = (__get_IPSR() == 0) && (__get_PRIMASK() == 0);
+    bool waited = false;
+
+    while (len != 0) {
+        uint16_t n = TXBUF_Write(b, data, len);
+        data += n;
+        len  -= n;
+        if (len == 0) break;
+
+        if (!can_wait) {
+            b->dropped += len;
+            break;
+        }
+        if (!waited) {
+            waited = true;
+            b->waits++;
+        }
+        while (TXBUF_Used(b) == b->mask) { }   // uvolni TX preruseni
+    }
+}
+
+void TXBUF_Puts(txbuf *b, const char *str) {
+    TXBUF_Send(b, str, (uint16_t)strlen(str));
+}
+
+//------------------------------------------------------------------------------
+// Pocka, az odejde i posledni bajt z posuvneho registru
+//------------------------------------------------------------------------------
+void TXBUF_Flush(txbuf *b) {
+    while (TXBUF_Used(b) != 0) { }
+    while ((b->usart->STATUS & USART_STATUS_TXIDLE) == 0) { }
+}
+
+//------------------------------------------------------------------------------
+// TX preruseni portu - plni vysilac, dokud ma misto (TXBL), pak se vypne
+//------------------------------------------------------------------------------
+void TXBUF_IRQHandler(txbuf *b) {
+    while (b->usart->STATUS & USART_STATUS_TXBL) {
+        if (b->tail == b->head) {
+            USART_IntDisable(b->usart, USART_IEN_TXBL);
+            return;
+        }
+        b->usart->TXDATA = (uint8_t)b->buf[b->tail];
+        b->tail = (uint16_t)((b->tail + 1) & b->mask);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Konec useku LDMA - posune tail a odesle dalsi usek. Obehy prijmu zpracuje
+// rxbuf.c, ostatni kanaly (hrany RX, TXSYNC) preruseni nepovoluji, jejich
+// priznaky se jen smazou.
+//------------------------------------------------------------------------------
+void LDMA_IRQHandler(void) {
+    uint32_t pending = LDMA_IntGetEnabled();
+
+    RXBUF_LdmaIrq(pending);
+    Input_EdgeLdmaIrq(pending);
+
+    for (uint8_t ch = 0; ch < DMA_CHAN_COUNT; ch++) {
+        txbuf *b = txbuf_dma[ch];
+        if (b == NULL || (pending & (1UL << ch)) == 0) continue;
+
+        LDMA_IntClear(1UL << ch);
+        b->tail = (uint16_t)((b->tail + b->dma_len) & b->mask);
+        b->dma_len = 0;
+        txbuf_dma_start(b);
+    }
+    LDMA_IntClear(pending);
+}
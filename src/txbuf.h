@@ -0,0 +1,42 @@
+/******************************************************************************
+ * @file txbuf.h
+ * @brief Kruhovy buffer vysilani UART/USART vyprazdnovany prerusenim TXBL nebo LDMA
+ *****************************************************************************/
+#ifndef TXBUF_H
+#define TXBUF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_usart.h"   /* USART_TypeDef */
+#include "em_ldma.h"
+
+//--- Buffer jednoho portu. Zapisuje hlavni smycka i preruseni (head, pod
+//    kratkymi zakazy preruseni po kusech), cte jen TX preruseni portu nebo LDMA (tail).
+typedef struct {
+    USART_TypeDef    *usart;
+    char             *buf;
+    uint16_t          mask;      // velikost - 1, velikost je mocnina 2
+    volatile uint16_t head;      // dalsi volne misto
+    volatile uint16_t tail;      // dalsi bajt k odeslani
+    uint16_t          hwm;       // nejvyssi zaplneni (high-water mark)
+    uint32_t          waits;     // kolikrat TXBUF_Send() cekal na misto
+    uint32_t          dropped;   // zahozene bajty (plny buffer v preruseni)
+    int8_t            dma_ch;    // kanal LDMA, -1 = vysila TXBL preruseni
+    uint32_t          dma_signal;
+    volatile uint16_t dma_len;   // bajty prave odesilane LDMA, 0 = kanal stoji
+    uint32_t          dma_xfers; // pocet prenosu LDMA
+    LDMA_Descriptor_t dma_desc;
+} txbuf;
+
+#define TXBUF_INIT(u, mem)  { .usart = (u), .buf = (mem), .mask = sizeof(mem) - 1, .dma_ch = -1 }
+
+uint16_t TXBUF_Write(txbuf *b, const char *data, uint16_t len);  // neblokujici, vraci prijate bajty
+void     TXBUF_Send(txbuf *b, const char *data, uint16_t len);   // ceka na misto, v preruseni zahazuje
+void     TXBUF_Puts(txbuf *b, const char *str);
+void     TXBUF_Flush(txbuf *b);                                  // ceka na odvysilani vseho
+uint16_t TXBUF_Used(const txbuf *b);
+uint16_t TXBUF_Size(const txbuf *b);
+void     TXBUF_IRQHandler(txbuf *b);                             // z UARTx_TX_IRQHandler
+void     TXBUF_InitDMA(txbuf *b, uint8_t ch, uint32_t signal);   // vysilani pres LDMA kanal ch
+
+#endif /* TXBUF_H */
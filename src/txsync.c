@@ -0,0 +1,107 @@
+/******************************************************************************
+ * @file txsync.c
+ * @brief Vysilani POCSAG pres USART1 v synchronnim rezimu a LDMA
+ *
+ * USART jako synchronni master vysila bity presne podle sveho delice, LDMA
+ * mu dodava bajty pripraveneho proudu (TXBL). Behem vysilani nebezi zadne
+ * preruseni, az TXC po poslednim bitu zavola POCSAG_tx_done().
+ *
+ * Sync rezim: bps = HFPERCLK / (2 * (1 + CLKDIV/256))
+ *   1200 bps: CLKDIV = (72 000 000 / 2400 - 1) * 256 = 29999 * 256
+ *   2400 bps: CLKDIV = 14999 * 256
+ *   512 bps nevejde do 15 bitu delice - vysila se pres TIMER1 (GPIO).
+ *
+ * Pin TXSYNC_TX_PORT/PIN (TXSYNC_TXLOC, viz ports.h) je push-pull vystup
+ * v klidu 0. Mimo vysilani je route vypnuty a pin drzi GPIO.
+ *****************************************************************************/
+#include "txsync.h"
+#include "ports.h"
+#include "pocsag.h"
+#include "timer1.h"
+
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_usart.h"
+#include "em_ldma.h"
+
+#define TXSYNC_CLKDIV(bps)  (((HFCLK_FREQ / (2UL * (bps))) - 1) << 8)
+#define TXSYNC_CLKDIV_MAX   (_USART_CLKDIV_DIV_MASK)
+
+static LDMA_Descriptor_t txsync_desc;
+
+//------------------------------------------------------------------------------
+// Init USART1 - synchronni master, MSB napred, 8 bitu
+//------------------------------------------------------------------------------
+void initTXSYNC(void)
+{
+    CMU_ClockEnable(TXSYNC_CLOCK, true);
+    CMU_ClockEnable(cmuClock_GPIO, true);
+
+    //-- Bez nastaveni pinu ROUTEPEN nic nevybudi (pin je gpioModeDisabled)
+    GPIO_PinModeSet(TXSYNC_TX_PORT, TXSYNC_TX_PIN, gpioModePushPull, 0);
+
+    TXSYNC_USART->CMD = USART_CMD_RXDIS | USART_CMD_TXDIS | USART_CMD_MASTERDIS
+                      | USART_CMD_RXBLOCKDIS | USART_CMD_TXTRIDIS
+                      | USART_CMD_CLEARTX | USART_CMD_CLEARRX;
+
+    TXSYNC_USART->CTRL  = USART_CTRL_SYNC | USART_CTRL_MSBF;
+    TXSYNC_USART->FRAME = USART_FRAME_DATABITS_EIGHT;
+    TXSYNC_USART->CLKDIV = TXSYNC_CLKDIV(POCSAG_BPS_DEFAULT);
+
+    TXSYNC_USART->ROUTEPEN  = 0;  // pin TX zapne az TXSYNC_Start()
+    TXSYNC_USART->ROUTELOC0 = (TXSYNC_TXLOC << _USART_ROUTELOC0_TXLOC_SHIFT);
+
+    TXSYNC_USART->CMD = USART_CMD_MASTEREN | USART_CMD_TXEN;
+
+    USART_IntClear(TXSYNC_USART, _USART_IF_MASK);
+    NVIC_ClearPendingIRQ(TXSYNC_TX_IRQn);
+    NVIC_EnableIRQ(TXSYNC_TX_IRQn);
+}
+
+bool TXSYNC_Supported(uint16_t bps)
+{
+    return TXSYNC_CLKDIV(bps) <= TXSYNC_CLKDIV_MAX;
+}
+
+//------------------------------------------------------------------------------
+// Spusti vysilani proudu bajtu (MSB napred), konec ohlasi TXC preruseni
+//------------------------------------------------------------------------------
+void TXSYNC_Start(const uint8_t *stream, uint16_t bytes, uint16_t bps)
+{
+    TXSYNC_USART->CLKDIV = TXSYNC_CLKDIV(bps);
+    TXSYNC_USART->CMD = USART_CMD_CLEARTX;
+    USART_IntClear(TXSYNC_USART, USART_IFC_TXC);
+    USART_IntEnable(TXSYNC_USART, USART_IEN_TXC);
+
+    TXSYNC_USART->ROUTEPEN = USART_ROUTEPEN_TXPEN;
+
+    txsync_desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(stream, &TXSYNC_USART->TXDATA, bytes);
+    txsync_desc.xfer.doneIfs = 0;  // konec hlasi TXC, ne LDMA
+    LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(TXSYNC_LDMA_SIGNAL);
+    LDMA_StartTransfer(LDMA_CH_TXSYNC, &cfg, &txsync_desc);
+}
+
+//------------------------------------------------------------------------------
+// Zastavi vysilani a vrati pin TX do GPIO
+//------------------------------------------------------------------------------
+void TXSYNC_Stop(void)
+{
+    LDMA_StopTransfer(LDMA_CH_TXSYNC);
+    USART_IntDisable(TXSYNC_USART, USART_IEN_TXC);
+    TXSYNC_USART->ROUTEPEN = 0;
+    TXSYNC_USART->CMD = USART_CMD_CLEARTX;
+}
+
+//------------------------------------------------------------------------------
+// TXC - odvysilan posledni bit proudu (handler musi odpovidat TXSYNC_USART)
+//------------------------------------------------------------------------------
+void USART1_TX_IRQHandler(void)
+{
+    uint32_t flags = USART_IntGet(TXSYNC_USART);
+    USART_IntClear(TXSYNC_USART, flags);
+
+    if ((flags & USART_IF_TXC) && LDMA_TransferDone(LDMA_CH_TXSYNC)) {
+        TXSYNC_Stop();
+        POCSAG_tx_done();
+    }
+}
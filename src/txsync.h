@@ -0,0 +1,16 @@
+/******************************************************************************
+ * @file txsync.h
+ * @brief Vysilani POCSAG pres USART1 v synchronnim rezimu a LDMA
+ *****************************************************************************/
+#ifndef TXSYNC_H
+#define TXSYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+void initTXSYNC(void);
+bool TXSYNC_Supported(uint16_t bps);   // rychlost jde nastavit delicem USART
+void TXSYNC_Start(const uint8_t *stream, uint16_t bytes, uint16_t bps);
+void TXSYNC_Stop(void);
+
+#endif /* TXSYNC_H */
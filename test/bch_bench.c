@@ -0,0 +1,111 @@
+/******************************************************************************
+ * @file bch_bench.c
+ * @brief Mereni BCH(31,21) na hostiteli - puvodni bitovy vypocet proti tabulkam
+ *
+ * Neni soucasti firmware - adresar test je v .cproject vyjmuty z prekladu
+ * (excluding="EFP|test"). Preklad a beh na hostiteli:
+ *
+ *   gcc -O2 -I../src -o bch_bench bch_bench.c ../src/bch.c
+ *   ./bch_bench [pocet_slov]
+ *
+ * Nahodna slova (10% platnych kodovych slov) se overi obema zpusoby, pri
+ * neshode syndromu nebo parity konci chybou. Vypis je v taktech na slovo
+ * (x86: RDTSC), jinde v ns na slovo.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "bch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT  "cyc"
+static uint64_t bench_now(void) { return __rdtsc(); }
+#else
+#define BENCH_UNIT  "ns"
+static uint64_t bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+//------------------------------------------------------------------------------
+// Puvodni calculate_syndrom() a check_parity() z pocsag.c (pred bch.c)
+//------------------------------------------------------------------------------
+static uint32_t old_syndrom(uint32_t word) {
+    uint32_t reg  = word & 0xFFFFFFFE;
+    uint32_t poly = 0xED200000;   // 0x769 zarovnany na bit 31
+
+    for (int i = 0; i < 21; i++) {
+        if (reg & (1UL << (31 - i))) {
+            reg ^= (poly >> i);
+        }
+    }
+    return (reg & 0x000007FE);
+}
+
+static bool old_parity(uint32_t word) {
+    uint32_t p = 0;
+    for (int i = 0; i < 32; i++) {
+        if (word & (1UL << i)) p++;
+    }
+    return (p % 2 == 0);
+}
+
+//------------------------------------------------------------------------------
+// xorshift32 - stejna slova pri kazdem behu
+//------------------------------------------------------------------------------
+static uint32_t rnd_state = 0x12345678;
+
+static uint32_t rnd(void) {
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+int main(int argc, char **argv) {
+    uint32_t n = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 10000000;
+    uint32_t *words = malloc(n * sizeof(uint32_t));
+    volatile uint32_t sink = 0;   // aby prekladac smycky nevypustil
+    uint64_t t0, t_old, t_new;
+
+    if (words == NULL || n == 0) return 1;
+
+    BCH_Init();
+    for (uint32_t i = 0; i < n; i++) {
+        words[i] = (i % 10 == 0) ? BCH_Encode(rnd()) : rnd();
+    }
+
+    //-- Shoda vysledku
+    for (uint32_t i = 0; i < n; i++) {
+        if (old_syndrom(words[i]) != BCH_Syndrome(words[i])
+         || old_parity(words[i])  != BCH_Parity(words[i])) {
+            printf("NESHODA slovo %lu: 0x%08lX\n", (unsigned long)i, (unsigned long)words[i]);
+            return 1;
+        }
+    }
+
+    //-- Syndrom + parita, jako pri kontrole prijateho slova
+    t0 = bench_now();
+    for (uint32_t i = 0; i < n; i++) {
+        sink += old_syndrom(words[i]) + old_parity(words[i]);
+    }
+    t_old = bench_now() - t0;
+
+    t0 = bench_now();
+    for (uint32_t i = 0; i < n; i++) {
+        sink += BCH_Syndrome(words[i]) + BCH_Parity(words[i]);
+    }
+    t_new = bench_now() - t0;
+
+    printf("%lu slov, bez neshody\n", (unsigned long)n);
+    printf("  bitovy syndrom + parita:  %6.1f %s/slovo\n", (double)t_old / n, BENCH_UNIT);
+    printf("  tabulkovy syndrom + XOR:  %6.1f %s/slovo\n", (double)t_new / n, BENCH_UNIT);
+
+    free(words);
+    return 0;
+}